@@ -11,6 +11,7 @@
 
 // Hardware configuration:
 // ADC0 SS3
+// ADC0 SS1 (up to 4 inputs converted from a single trigger)
 
 //-----------------------------------------------------------------------------
 // Device includes, defines, and assembler directives
@@ -27,6 +28,8 @@
 // Global variables
 //-----------------------------------------------------------------------------
 
+uint8_t ss1SampleCount = 0;
+
 //-----------------------------------------------------------------------------
 // Subroutines
 //-----------------------------------------------------------------------------
@@ -75,3 +78,64 @@ int16_t readAdc0Ss3()
     while (ADC0_SSFSTAT3_R & ADC_SSFSTAT3_EMPTY);
     return ADC0_SSFIFO3_R;                           // get single result from the FIFO
 }
+
+// Initialize SS1, call after initAdc0Ss3() which sets up the ADC clock and rate
+void initAdc0Ss1()
+{
+    ADC0_ACTSS_R &= ~ADC_ACTSS_ASEN1;                // disable sample sequencer 1 (SS1) for programming
+    ADC0_EMUX_R &= ~ADC_EMUX_EM1_M;                  // select SS1 bit in ADCPSSI as trigger
+    ADC0_SSCTL1_R = ADC_SSCTL1_END0;                 // mark first sample as the end until the mux is set
+    ss1SampleCount = 1;
+    ADC0_ACTSS_R |= ADC_ACTSS_ASEN1;                 // enable SS1 for operation
+}
+
+// Set the SS1 analog inputs, one step per input (up to 4), converted in order
+// ADC0_INPUT_TS in place of an input samples the internal temperature sensor
+void setAdc0Ss1Mux(const uint8_t inputs[], uint8_t count)
+{
+    uint32_t mux = 0;
+    uint32_t ctl = 0;
+    uint8_t i;
+
+    if(count > 4)
+        count = 4;
+    for(i = 0; i < count; i++)
+    {
+        if(inputs[i] == ADC0_INPUT_TS)
+            ctl |= ADC_SSCTL1_TS0 << (i * 4);
+        else
+            mux |= (uint32_t)(inputs[i] & 0xF) << (i * 4);
+    }
+
+    ADC0_ACTSS_R &= ~ADC_ACTSS_ASEN1;                // disable sample sequencer 1 (SS1) for programming
+    ADC0_SSMUX1_R = mux;                             // set analog input for each step
+    ADC0_SSCTL1_R = ctl | (ADC_SSCTL1_END0 << ((count - 1) * 4));
+                                                     // mark the last step as the end
+    ss1SampleCount = count;
+    ADC0_ACTSS_R |= ADC_ACTSS_ASEN1;                 // enable SS1 for operation
+}
+
+// Request one SS1 sequence without waiting for it, collect it with getAdc0Ss1Results()
+void startAdc0Ss1()
+{
+    ADC0_PSSI_R |= ADC_PSSI_SS1;                     // set start bit
+}
+
+// Read every step of the SS1 sequence started last into results, in mux order
+void getAdc0Ss1Results(int16_t results[])
+{
+    uint8_t i;
+    while (ADC0_ACTSS_R & ADC_ACTSS_BUSY);           // wait until SS1 is not busy
+    for(i = 0; i < ss1SampleCount; i++)
+    {
+        while (ADC0_SSFSTAT1_R & ADC_SSFSTAT1_EMPTY);
+        results[i] = ADC0_SSFIFO1_R;                 // get the results from the FIFO in step order
+    }
+}
+
+// Request one SS1 sequence and read every step into results, in mux order
+void readAdc0Ss1(int16_t results[])
+{
+    startAdc0Ss1();
+    getAdc0Ss1Results(results);
+}
@@ -11,6 +11,7 @@
 
 // Hardware configuration:
 // ADC0 SS3
+// ADC0 SS1 (up to 4 inputs converted from a single trigger)
 
 //-----------------------------------------------------------------------------
 // Device includes, defines, and assembler directives
@@ -19,6 +20,9 @@
 #ifndef ADC0_H_
 #define ADC0_H_
 
+// SS1 input that selects the internal temperature sensor instead of an AIN pin
+#define ADC0_INPUT_TS 16
+
 //-----------------------------------------------------------------------------
 // Subroutines
 //-----------------------------------------------------------------------------
@@ -27,5 +31,10 @@ void initAdc0Ss3();
 void setAdc0Ss3Log2AverageCount(uint8_t log2AverageCount);
 void setAdc0Ss3Mux(uint8_t input);
 int16_t readAdc0Ss3();
+void initAdc0Ss1();
+void setAdc0Ss1Mux(const uint8_t inputs[], uint8_t count);
+void startAdc0Ss1();
+void getAdc0Ss1Results(int16_t results[]);
+void readAdc0Ss1(int16_t results[]);
 
 #endif
@@ -57,6 +57,43 @@ void getsUart0(USER_DATA* data)
     }
 }
 
+// Non-blocking version of getsUart0
+// Consumes whatever has arrived and returns true once a full line is in the buffer
+// The partial line is kept in data->count between calls, so clear it before the first call
+bool tryGetsUart0(USER_DATA* data)
+{
+    while(kbhitUart0())
+    {
+        char c = getcUart0();
+
+        // If the character is a backspace
+        // Ctrl-H or Ctrl-?
+        if(c == 8 || c == 127)
+        {
+            if(data->count > 0)
+                data->count--;
+        }
+        // If the character is a carriage return (13) or a line feed (10)
+        else if(c == 13 || c == 10)
+        {
+            data->buffer[data->count] = '\0';
+            data->count = 0;
+            return true;
+        }
+        else if(c >= 32)
+        {
+            data->buffer[data->count++] = c;
+            if(data->count == MAX_CHARS)
+            {
+                data->buffer[data->count] = '\0';
+                data->count = 0;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
 // Tokenizes the string in place
 void parseField(USER_DATA* data)
 {
@@ -65,8 +102,16 @@ void parseField(USER_DATA* data)
     data->fieldCount = 0;
     for(i = 0; (data->buffer[i] != '\0') && (data->fieldCount < MAX_FIELDS); i++)
     {
+        // A minus sign right before a digit starts a number field, getSignedInteger() reads it
+        if(data->buffer[i] == '-' && !IsNewToken &&
+           data->buffer[i + 1] >= '0' && data->buffer[i + 1] <= '9')
+        {
+            IsNewToken = true;
+            data->fieldPosition[data->fieldCount] = i;
+            data->fieldType[data->fieldCount++] = 'n';
+        }
         // Only tokenize alpha numeric characters
-        if(((data->buffer[i] >= 'a' && data->buffer[i] <= 'z') ||
+        else if(((data->buffer[i] >= 'a' && data->buffer[i] <= 'z') ||
             (data->buffer[i] >= '0' && data->buffer[i] <= '9') ||
             (data->buffer[i] >= 'A' && data->buffer[i] <= 'Z')) &&
             !IsNewToken)
@@ -123,10 +168,12 @@ int32_t getFieldInteger(USER_DATA* data, uint8_t fieldNumber)
     return 0;
 }
 
-// Gets an integer value from the buffer
-uint8_t getInteger(USER_DATA* data, uint8_t position)
+// Gets an integer value from the buffer, a minus sign is skipped
+uint32_t getInteger(USER_DATA* data, uint8_t position)
 {
-    uint8_t integerVal = 0;
+    uint32_t integerVal = 0;
+    if(data->buffer[position] == '-')
+        position++;
     while(data->buffer[position] != '\0')
     {
         integerVal = (integerVal * 10) + (data->buffer[position] - '0');
@@ -135,6 +182,60 @@ uint8_t getInteger(USER_DATA* data, uint8_t position)
     return integerVal;
 }
 
+// Gets an integer value with an optional minus sign from the buffer
+int32_t getSignedInteger(USER_DATA* data, uint8_t position)
+{
+    if(data->buffer[position] == '-')
+        return -(int32_t)getInteger(data, position + 1);
+    return getInteger(data, position);
+}
+
+// Gets a value with an optional engineering suffix from the buffer, e.g. 470, 4k7, 100n or 2u2
+// The suffix (p, n, u, m, r, k or M) stands in for the decimal point, which the parser treats as a delimiter
+// Returns 0 for an unknown suffix
+float getEngineering(USER_DATA* data, uint8_t position)
+{
+    float value = 0;
+    float place = 1;
+    float scale = 1;
+    bool isFraction = false;
+
+    while(data->buffer[position] != '\0')
+    {
+        char c = data->buffer[position];
+        if(c >= '0' && c <= '9')
+        {
+            if(isFraction)
+            {
+                place /= 10;
+                value += (c - '0') * place;
+            }
+            else
+                value = (value * 10) + (c - '0');
+        }
+        else if(!isFraction)
+        {
+            switch(c)
+            {
+                case 'p': scale = 1e-12f; break;
+                case 'n': scale = 1e-9f; break;
+                case 'u': scale = 1e-6f; break;
+                case 'm': scale = 1e-3f; break;
+                case 'r':
+                case 'R': scale = 1; break;
+                case 'k': scale = 1e3f; break;
+                case 'M': scale = 1e6f; break;
+                default: return 0;
+            }
+            isFraction = true;
+        }
+        else
+            return 0;
+        position++;
+    }
+    return value * scale;
+}
+
 // Get a pointer to the requested string field
 char* getFieldString(USER_DATA* data, uint8_t fieldNumber)
 {
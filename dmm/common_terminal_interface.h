@@ -10,7 +10,7 @@
 #define COMMON_TERMINAL_INTERFACE_H_
 
 #define MAX_CHARS 80
-#define MAX_FIELDS 5
+#define MAX_FIELDS 6
 
 //-----------------------------------------------------------------------------
 // Structs
@@ -18,16 +18,20 @@
 typedef struct _USER_DATA
 {
     char buffer[MAX_CHARS + 1];
+    uint8_t count;
     uint8_t fieldCount;
     uint8_t fieldPosition[MAX_FIELDS];
     char fieldType[MAX_FIELDS];
 } USER_DATA;
 
 void getsUart0(USER_DATA* data);
+bool tryGetsUart0(USER_DATA* data);
 void parseField(USER_DATA* data);
 bool isCommand(USER_DATA* data, const char strCommand[], uint8_t minArguments);
 int32_t getFieldInteger(USER_DATA* data, uint8_t fieldNumber);
-uint8_t getInteger(USER_DATA* data, uint8_t position);
+uint32_t getInteger(USER_DATA* data, uint8_t position);
+int32_t getSignedInteger(USER_DATA* data, uint8_t position);
+float getEngineering(USER_DATA* data, uint8_t position);
 char* getFieldString(USER_DATA* data, uint8_t fieldNumber);
 bool stringCompare(const char string1[], const char string2[]);
 void strCpy(const char* str1, char* str2);
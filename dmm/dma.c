@@ -0,0 +1,77 @@
+// DMA Library
+// Sarker Nadir Afridi Azmi
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Hardware configuration:
+// uDMA, basic mode transfers from memory to a peripheral
+//   Channel 9 (encoding 0) is UART0 TX
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tm4c123gh6pm.h"
+#include "dma.h"
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+// Only the primary structures, nothing uses the alternate ones (ping-pong or scatter-gather)
+// The controller needs the table on a 1 KiB boundary
+#ifdef SIMULATOR
+DMA_CONTROL dmaControlTable[DMA_CHANNEL_COUNT] __attribute__((aligned(1024)));
+#else
+#pragma DATA_ALIGN(dmaControlTable, 1024)
+DMA_CONTROL dmaControlTable[DMA_CHANNEL_COUNT];
+#endif
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initDma()
+{
+    SYSCTL_RCGCDMA_R |= SYSCTL_RCGCDMA_R0;
+    _delay_cycles(3);
+    UDMA_CFG_R = UDMA_CFG_MASTEN;
+    UDMA_CTLBASE_R = (uintptr_t)dmaControlTable;
+
+    // UART0 TX on channel 9, primary structure, single and burst requests
+    UDMA_CHMAP1_R &= ~UDMA_CHMAP1_CH9SEL_M;
+    UDMA_PRIOCLR_R = 1 << DMA_CHANNEL_UART0_TX;
+    UDMA_ALTCLR_R = 1 << DMA_CHANNEL_UART0_TX;
+    UDMA_USEBURSTCLR_R = 1 << DMA_CHANNEL_UART0_TX;
+    UDMA_REQMASKCLR_R = 1 << DMA_CHANNEL_UART0_TX;
+}
+
+// Bytes from memory to a fixed peripheral register, the peripheral paces the transfer
+// The channel turns itself off when done and the peripheral's interrupt comes in
+void startDmaToPeripheral(uint8_t channel, const void* source, volatile uint32_t* destination, uint16_t count, uint32_t arbitration)
+{
+    DMA_CONTROL* entry = &dmaControlTable[channel];
+    entry->sourceEnd = (uintptr_t)source + count - 1;
+    entry->destinationEnd = (uintptr_t)destination;
+    entry->control = UDMA_CHCTL_DSTINC_NONE | UDMA_CHCTL_DSTSIZE_8 | UDMA_CHCTL_SRCINC_8 | UDMA_CHCTL_SRCSIZE_8
+                   | arbitration | ((count - 1) << UDMA_CHCTL_XFERSIZE_S) | UDMA_CHCTL_XFERMODE_BASIC;
+    UDMA_ENASET_R = 1 << channel;
+}
+
+bool isDmaDone(uint8_t channel)
+{
+    return !(UDMA_ENASET_R & (1 << channel));
+}
+
+void clearDmaInterrupt(uint8_t channel)
+{
+    UDMA_CHIS_R = 1 << channel;
+}
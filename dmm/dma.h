@@ -0,0 +1,53 @@
+// DMA Library
+// Sarker Nadir Afridi Azmi
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Hardware configuration:
+// uDMA, basic mode transfers from memory to a peripheral
+//   Channel 9 (encoding 0) is UART0 TX
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef DMA_H_
+#define DMA_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define DMA_CHANNEL_COUNT       32
+#define DMA_CHANNEL_UART0_TX    9
+// Most items one basic mode transfer can move
+#define DMA_MAX_TRANSFER        1024
+
+//-----------------------------------------------------------------------------
+// Structs
+//-----------------------------------------------------------------------------
+
+// One entry of the channel control table, the addresses are of the last item
+typedef struct _DMA_CONTROL
+{
+    volatile uintptr_t sourceEnd;
+    volatile uintptr_t destinationEnd;
+    volatile uint32_t control;
+    uint32_t unused;
+} DMA_CONTROL;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initDma();
+void startDmaToPeripheral(uint8_t channel, const void* source, volatile uint32_t* destination, uint16_t count, uint32_t arbitration);
+bool isDmaDone(uint8_t channel);
+void clearDmaInterrupt(uint8_t channel);
+
+#endif
@@ -0,0 +1,233 @@
+// Charge Curve Fit and DUT2 Burst Library
+// Sarker Nadir Afridi Azmi
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Hardware configuration:
+// ADC1 SS3 samples DUT2 (AIN3), triggered by Timer 2A
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include "tm4c123gh6pm.h"
+#include "measure.h"
+#include "fit.h"
+#include "scheduler.h"
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+// Written by adc1Ss3Isr(), only read once fitDone is set or sampling is stopped
+uint16_t fitRaw[FIT_MAX_SAMPLES];
+uint32_t fitTime[FIT_MAX_SAMPLES];
+volatile uint8_t fitSampleCount = 0;
+volatile bool fitDone = false;
+uint32_t fitPeriod = FIT_START_PERIOD;
+uint32_t fitElapsed = 0;
+// Non-zero while taking a fixed length burst, the buffer is not decimated then
+uint8_t burstCount = 0;
+
+uint16_t fitEndMv = FIT_END_MV;
+uint16_t fitEndRaw = (FIT_END_MV * 4096) / (VSUPPLY * 1000);
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initChargeFit()
+{
+    // Enable clocks
+    SYSCTL_RCGCADC_R |= SYSCTL_RCGCADC_R1;
+    SYSCTL_RCGCTIMER_R |= SYSCTL_RCGCTIMER_R2;
+    _delay_cycles(16);
+
+    // Configure ADC1 SS3 to convert DUT2 every time Timer 2A times out
+    ADC1_ACTSS_R &= ~ADC_ACTSS_ASEN3;                // disable sample sequencer 3 (SS3) for programming
+    ADC1_CC_R = ADC_CC_CS_SYSPLL;                    // select PLL as the time base (not needed, since default value)
+    ADC1_PC_R = ADC_PC_SR_1M;                        // select 1Msps rate
+    ADC1_EMUX_R = ADC_EMUX_EM3_TIMER;                // select timer as the SS3 trigger
+    ADC1_SSMUX3_R = 3;                               // AIN3 = DUT2
+    ADC1_SSCTL3_R = ADC_SSCTL3_END0 | ADC_SSCTL3_IE0;
+                                                     // single sample, interrupt at the end
+    ADC1_IM_R |= ADC_IM_MASK3;
+    ADC1_ACTSS_R |= ADC_ACTSS_ASEN3;                 // enable SS3 for operation
+    // Vector Number = 67, Interrupt Number = 51
+    NVIC_EN1_R |= 1 << (INT_ADC1SS3-16-32);
+
+    TIMER2_CTL_R &= ~TIMER_CTL_TAEN;                 // turn-off timer before reconfiguring
+    TIMER2_CFG_R = TIMER_CFG_32_BIT_TIMER;           // configure as 32-bit timer (A+B)
+    TIMER2_TAMR_R = TIMER_TAMR_TAMR_PERIOD;          // configure for periodic mode (count down)
+    TIMER2_CTL_R |= TIMER_CTL_TAOTE;                 // trigger the ADC on every time-out
+}
+
+// Sets the DUT2 voltage at which there are enough samples to fit the curve
+void setChargeFitEnd(uint16_t endMv)
+{
+    fitEndMv = endMv;
+    fitEndRaw = (endMv * 4096) / (VSUPPLY * 1000);
+}
+
+uint16_t getChargeFitEnd()
+{
+    return fitEndMv;
+}
+
+// Starts sampling, call this at the same time the DUT starts charging
+void startChargeFit()
+{
+    TIMER2_CTL_R &= ~TIMER_CTL_TAEN;
+    fitSampleCount = 0;
+    fitDone = false;
+    fitPeriod = FIT_START_PERIOD;
+    fitElapsed = 0;
+    burstCount = 0;
+    ADC1_ISC_R = ADC_ISC_IN3;
+    TIMER2_TAILR_R = fitPeriod - 1;
+    TIMER2_CTL_R |= TIMER_CTL_TAEN;
+}
+
+void stopChargeFit()
+{
+    TIMER2_CTL_R &= ~TIMER_CTL_TAEN;
+    fitDone = false;
+}
+
+bool isChargeFitReady()
+{
+    return fitDone;
+}
+
+// Stores one DUT2 sample
+// When the buffer is full every other sample is dropped and the sample period doubles,
+// so the buffer always spans the whole charge no matter how slow it is
+// Posts EVENT_MEASURE once the fit or the burst has its samples
+void adc1Ss3Isr()
+{
+    uint16_t raw = ADC1_SSFIFO3_R;
+    ADC1_ISC_R = ADC_ISC_IN3;
+    fitElapsed += fitPeriod;
+
+    if(fitDone)
+        return;
+
+    if(burstCount > 0)
+    {
+        fitRaw[fitSampleCount] = raw;
+        fitTime[fitSampleCount] = fitElapsed;
+        if(++fitSampleCount == burstCount)
+        {
+            TIMER2_CTL_R &= ~TIMER_CTL_TAEN;
+            fitDone = true;
+            postEvent(EVENT_MEASURE);
+        }
+        return;
+    }
+
+    if(fitSampleCount == FIT_MAX_SAMPLES)
+    {
+        uint8_t i;
+        for(i = 0; i < FIT_MAX_SAMPLES / 2; i++)
+        {
+            fitRaw[i] = fitRaw[2 * i + 1];
+            fitTime[i] = fitTime[2 * i + 1];
+        }
+        fitSampleCount = FIT_MAX_SAMPLES / 2;
+        fitPeriod *= 2;
+        TIMER2_TAILR_R = fitPeriod - 1;
+    }
+
+    fitRaw[fitSampleCount] = raw;
+    fitTime[fitSampleCount] = fitElapsed;
+    fitSampleCount++;
+
+    if(raw >= fitEndRaw && fitSampleCount >= FIT_MIN_SAMPLES)
+    {
+        TIMER2_CTL_R &= ~TIMER_CTL_TAEN;
+        fitDone = true;
+        postEvent(EVENT_MEASURE);
+    }
+}
+
+/*
+ * Fits V(t) = VSUPPLY * (1 - A * e^(-t / tau)) to the samples and returns tau in system clocks
+ * ln(1 - V / VSUPPLY) = ln(A) - t / tau is a straight line, so this is a least squares line fit
+ * A absorbs whatever voltage was left on the DUT when charging started
+ */
+bool getChargeFitTau(float* tau)
+{
+    double sumT = 0, sumY = 0, sumTT = 0, sumTY = 0;
+    uint8_t n = 0;
+    uint8_t i;
+
+    for(i = 0; i < fitSampleCount; i++)
+    {
+        double v = (VSUPPLY * (fitRaw[i] + 0.5)) / 4096.0;
+        if(v >= VSUPPLY)
+            continue;
+        double t = fitTime[i];
+        double y = log(1.0 - v / VSUPPLY);
+        sumT += t;
+        sumY += y;
+        sumTT += t * t;
+        sumTY += t * y;
+        n++;
+    }
+
+    if(n < FIT_MIN_SAMPLES)
+        return false;
+
+    double slope = (n * sumTY - sumT * sumY) / (n * sumTT - sumT * sumT);
+    if(slope >= 0)
+        return false;
+
+    *tau = -1.0 / slope;
+    return true;
+}
+
+// Takes count samples of DUT2, period system clocks apart
+void startDut2Burst(uint32_t period, uint8_t count)
+{
+    TIMER2_CTL_R &= ~TIMER_CTL_TAEN;
+    fitSampleCount = 0;
+    fitDone = false;
+    fitPeriod = period;
+    fitElapsed = 0;
+    burstCount = (count > FIT_MAX_SAMPLES) ? FIT_MAX_SAMPLES : count;
+    ADC1_ISC_R = ADC_ISC_IN3;
+    TIMER2_TAILR_R = fitPeriod - 1;
+    TIMER2_CTL_R |= TIMER_CTL_TAEN;
+}
+
+bool isDut2BurstDone()
+{
+    return fitDone;
+}
+
+// Returns the average DUT2 voltage over the first and the last quarter of the burst
+void getDut2BurstTrend(float* start, float* end)
+{
+    uint8_t quarter = fitSampleCount / 4;
+    uint32_t startSum = 0, endSum = 0;
+    uint8_t i;
+
+    if(quarter == 0)
+        quarter = 1;
+    for(i = 0; i < quarter; i++)
+    {
+        startSum += fitRaw[i];
+        endSum += fitRaw[fitSampleCount - 1 - i];
+    }
+    *start = (VSUPPLY * (((float)startSum / quarter) + 0.5)) / 4096.0;
+    *end = (VSUPPLY * (((float)endSum / quarter) + 0.5)) / 4096.0;
+}
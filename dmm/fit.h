@@ -0,0 +1,48 @@
+// Charge Curve Fit and DUT2 Burst Library
+// Sarker Nadir Afridi Azmi
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Hardware configuration:
+// ADC1 SS3 samples DUT2 (AIN3), triggered by Timer 2A
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef FIT_H_
+#define FIT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Samples kept for the fit, the sample period doubles every time the buffer fills up
+#define FIT_MAX_SAMPLES         64
+#define FIT_MIN_SAMPLES         16
+// First sample period in system clocks (10 us)
+#define FIT_START_PERIOD        400
+// Default voltage at which the fit stops sampling, about 0.2 time constants
+#define FIT_END_MV              600
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initChargeFit();
+void setChargeFitEnd(uint16_t endMv);
+uint16_t getChargeFitEnd();
+void startChargeFit();
+void stopChargeFit();
+bool isChargeFitReady();
+bool getChargeFitTau(float* tau);
+void startDut2Burst(uint32_t period, uint8_t count);
+bool isDut2BurstDone();
+void getDut2BurstTrend(float* start, float* end);
+
+#endif
@@ -0,0 +1,140 @@
+// Format Library
+// Sarker Nadir Afridi Azmi
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    -
+
+// Hardware configuration:
+// None, this is a small replacement for sprintf("%.2f") that does not pull in the float printf
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include "format.h"
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+// Engineering prefixes from 1e-12 to 1e9, index 4 is no prefix
+const char prefixes[] = {'p', 'n', 'u', 'm', 0, 'k', 'M', 'G'};
+#define PREFIX_NONE 4
+#define PREFIX_COUNT 8
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+char* formatString(char* str, const char* s)
+{
+    while(*s != '\0')
+        *str++ = *s++;
+    *str = '\0';
+    return str;
+}
+
+char* formatUnsigned(char* str, uint32_t value)
+{
+    char digits[10];
+    uint8_t count = 0;
+
+    // Digits come out least significant first
+    do
+    {
+        digits[count++] = '0' + (value % 10);
+        value /= 10;
+    } while(value > 0);
+
+    while(count > 0)
+        *str++ = digits[--count];
+    *str = '\0';
+    return str;
+}
+
+// Prints value / 10^decimals, e.g. formatFixed(str, -1234, 2) gives "-12.34"
+char* formatFixed(char* str, int32_t value, uint8_t decimals)
+{
+    uint32_t magnitude;
+    uint32_t scale = 1;
+    uint8_t i;
+
+    if(value < 0)
+    {
+        *str++ = '-';
+        magnitude = -(uint32_t)value;
+    }
+    else
+        magnitude = value;
+
+    for(i = 0; i < decimals; i++)
+        scale *= 10;
+
+    str = formatUnsigned(str, magnitude / scale);
+    if(decimals > 0)
+    {
+        uint32_t fraction = magnitude % scale;
+        *str++ = '.';
+        // Leading zeros of the fraction
+        for(scale /= 10; scale > 1 && fraction < scale; scale /= 10)
+            *str++ = '0';
+        str = formatUnsigned(str, fraction);
+    }
+    return str;
+}
+
+// Prints value with two decimals and an engineering prefix, e.g. 0.00047 with "F" gives "470.00 uF"
+char* formatEngineering(char* str, float value, const char* unit)
+{
+    uint8_t prefix = PREFIX_NONE;
+    uint32_t scaled;
+
+    // NaN is the only value that is not equal to itself
+    if(value != value)
+        return formatString(str, "nan");
+
+    if(value < 0)
+    {
+        *str++ = '-';
+        value = -value;
+    }
+
+    // Bring the mantissa into [1, 1000)
+    if(value != 0)
+    {
+        while(value >= 1000 && prefix < PREFIX_COUNT - 1)
+        {
+            value /= 1000;
+            prefix++;
+        }
+        while(value < 1 && prefix > 0)
+        {
+            value *= 1000;
+            prefix--;
+        }
+    }
+
+    // Anything that still doesn't fit is out of range for a two decimal mantissa
+    if(value >= 1000000)
+        return formatString(str, "overflow");
+
+    // Round to two decimals, rounding can carry into the next prefix (999.996 -> 1.00 k)
+    scaled = (uint32_t)(value * 100 + 0.5);
+    if(scaled >= 100000 && prefix < PREFIX_COUNT - 1)
+    {
+        scaled = (scaled + 500) / 1000;
+        prefix++;
+    }
+
+    str = formatFixed(str, scaled, 2);
+    *str++ = ' ';
+    if(prefixes[prefix] != 0)
+        *str++ = prefixes[prefix];
+    return formatString(str, unit);
+}
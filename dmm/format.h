@@ -0,0 +1,35 @@
+// Format Library
+// Sarker Nadir Afridi Azmi
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    -
+
+// Hardware configuration:
+// None, this is a small replacement for sprintf("%.2f") that does not pull in the float printf
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef FORMAT_H_
+#define FORMAT_H_
+
+#include <stdint.h>
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// All of these write at str, null terminate and return a pointer to the terminator,
+// so calls can be chained to build a line without strcat
+char* formatString(char* str, const char* s);
+char* formatUnsigned(char* str, uint32_t value);
+char* formatFixed(char* str, int32_t value, uint8_t decimals);
+char* formatEngineering(char* str, float value, const char* unit);
+
+#endif
@@ -26,6 +26,8 @@
 #define OFS_DATA_TO_IBE    3*4*8
 #define OFS_DATA_TO_IEV    4*4*8
 #define OFS_DATA_TO_IM     5*4*8
+#define OFS_DATA_TO_RIS    6*4*8
+#define OFS_DATA_TO_ICR    8*4*8
 #define OFS_DATA_TO_AFSEL  9*4*8
 #define OFS_DATA_TO_ODR   68*4*8
 #define OFS_DATA_TO_PUR   69*4*8
@@ -293,6 +295,21 @@ void disablePinInterrupt(PORT port, uint8_t pin)
     *p = 0;
 }
 
+// Raw interrupt status, set by the selected edge or level even if the interrupt is masked
+bool getPinInterruptStatus(PORT port, uint8_t pin)
+{
+    uint32_t* p;
+    p = (uint32_t*)port + pin + OFS_DATA_TO_RIS;
+    return *p;
+}
+
+void clearPinInterrupt(PORT port, uint8_t pin)
+{
+    uint32_t* p;
+    p = (uint32_t*)port + pin + OFS_DATA_TO_ICR;
+    *p = 1;
+}
+
 void setPinValue(PORT port, uint8_t pin, bool value)
 {
     uint32_t* p;
@@ -0,0 +1,231 @@
+// History Library
+// Sarker Nadir Afridi Azmi
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Hardware configuration:
+// UART0 for the binary dump, on uDMA when UART0 has it turned on
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include "tm4c123gh6pm.h"
+#include "uart0.h"
+#include "measure.h"
+#include "history.h"
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+// Once full the oldest reading is overwritten
+HISTORY_RECORD history[HISTORY_SIZE];
+uint16_t historyHead = 0;
+uint16_t historyCount = 0;
+
+// The dump frame around the records and where the records are, the DMA callback works through them in order
+uint8_t dumpHeader[8];
+uint8_t dumpTrailer[2];
+uint16_t dumpFirst;
+uint16_t dumpCount;
+uint8_t dumpPiece;
+volatile bool isHistoryDumping = false;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Called for every result that comes out of the engine
+void addHistory(MEASUREMENT_RESULT* result)
+{
+    HISTORY_RECORD* record = &history[historyHead];
+
+    // The oldest record may still be on its way out, so a full history takes nothing during a dump
+    if(isHistoryDumping && historyCount == HISTORY_SIZE)
+        return;
+    float esr = result->esr * 1000;
+    float temperature = result->temperature * 10;
+
+    record->time = result->time;
+    record->countLow = result->count;
+    record->countHigh = result->count >> 32;
+    // Noise can take a very low esr below 0, which has no uint16_t value (nor has NaN)
+    if(!(esr > 0))
+        record->esr = 0;
+    else
+        record->esr = (esr < 65535) ? (uint16_t)(esr + 0.5f) : 65535;
+    record->temperature = temperature + ((temperature < 0) ? -0.5f : 0.5f);
+    record->type = result->type;
+    record->status = result->status;
+    record->value = result->value;
+
+    historyHead = (historyHead + 1) & (HISTORY_SIZE - 1);
+    if(historyCount < HISTORY_SIZE)
+        historyCount++;
+}
+
+// Refused while a dump is on its way out, the DMA is still reading the records and the crc is already worked out
+bool clearHistory()
+{
+    if(isHistoryDumping)
+        return false;
+    historyHead = 0;
+    historyCount = 0;
+    return true;
+}
+
+uint16_t getHistoryCount()
+{
+    return historyCount;
+}
+
+HISTORY_RECORD* getHistoryRecord(uint16_t i)
+{
+    return &history[(historyHead - historyCount + i) & (HISTORY_SIZE - 1)];
+}
+
+// Min, max, mean and standard deviation of the good readings of one type
+// Welford's update, so the mean is never far from the readings and nothing cancels
+bool getHistoryStats(MEASUREMENT_TYPE type, HISTORY_STATS* stats)
+{
+    float m2 = 0;
+    uint16_t i;
+
+    stats->count = 0;
+    stats->mean = 0;
+    for(i = 0; i < historyCount; i++)
+    {
+        HISTORY_RECORD* record = getHistoryRecord(i);
+        if(record->type != type || record->status != RESULT_OK)
+            continue;
+        float value = record->value;
+        if(stats->count == 0 || value < stats->min)
+            stats->min = value;
+        if(stats->count == 0 || value > stats->max)
+            stats->max = value;
+        stats->count++;
+        float delta = value - stats->mean;
+        stats->mean += delta / stats->count;
+        m2 += delta * (value - stats->mean);
+    }
+    stats->stddev = (stats->count > 1) ? sqrtf(m2 / (stats->count - 1)) : 0;
+    return stats->count > 0;
+}
+
+uint16_t updateCrc(uint16_t crc, uint8_t data)
+{
+    uint8_t i;
+    crc ^= (uint16_t)data << 8;
+    for(i = 0; i < 8; i++)
+        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    return crc;
+}
+
+// Sends a byte and adds it to the crc
+uint16_t putDumpByte(uint16_t crc, uint8_t data)
+{
+    putcUart0(data);
+    return updateCrc(crc, data);
+}
+
+// Hands the DMA the pieces of the frame after the header in order, called from uart0Isr()
+bool getNextDumpPiece(const void** data, uint16_t* size)
+{
+    uint16_t toEnd = HISTORY_SIZE - dumpFirst;
+    uint16_t firstCount = (dumpCount < toEnd) ? dumpCount : toEnd;
+
+    // Records up to the end of the array
+    if(dumpPiece == 0 && firstCount > 0)
+    {
+        dumpPiece = 1;
+        *data = &history[dumpFirst];
+        *size = firstCount * sizeof(HISTORY_RECORD);
+        return true;
+    }
+    // The rest of them from the start of the array
+    if(dumpPiece <= 1 && dumpCount > firstCount)
+    {
+        dumpPiece = 2;
+        *data = &history[0];
+        *size = (dumpCount - firstCount) * sizeof(HISTORY_RECORD);
+        return true;
+    }
+    if(dumpPiece <= 2)
+    {
+        dumpPiece = 3;
+        *data = dumpTrailer;
+        *size = sizeof(dumpTrailer);
+        return true;
+    }
+    isHistoryDumping = false;
+    return false;
+}
+
+// Sends the history as one binary frame, see history.h, the history is kept
+// On DMA this returns once the frame has started, readings carry on while it goes out
+void dumpHistory()
+{
+    uint16_t crc = 0xFFFF;
+    uint16_t i;
+    uint8_t j;
+
+    if(isUart0DmaEnabled())
+    {
+        // Anything already queued, or the last dump, goes out first
+        while(isUart0DmaBusy() || !isUart0QueueEmpty())
+            serviceUart0();
+
+        dumpFirst = (historyHead - historyCount) & (HISTORY_SIZE - 1);
+        dumpCount = historyCount;
+        dumpHeader[0] = 'L';
+        dumpHeader[1] = 'C';
+        dumpHeader[2] = 'R';
+        dumpHeader[3] = 'H';
+        dumpHeader[4] = dumpCount;
+        dumpHeader[5] = dumpCount >> 8;
+        dumpHeader[6] = sizeof(HISTORY_RECORD);
+        dumpHeader[7] = sizeof(HISTORY_RECORD) >> 8;
+        for(i = 4; i < sizeof(dumpHeader); i++)
+            crc = updateCrc(crc, dumpHeader[i]);
+        for(i = 0; i < dumpCount; i++)
+        {
+            uint8_t* bytes = (uint8_t*)getHistoryRecord(i);
+            for(j = 0; j < sizeof(HISTORY_RECORD); j++)
+                crc = updateCrc(crc, bytes[j]);
+        }
+        dumpTrailer[0] = crc & 0xFF;
+        dumpTrailer[1] = crc >> 8;
+        dumpPiece = 0;
+        isHistoryDumping = true;
+        sendUart0Dma(dumpHeader, sizeof(dumpHeader), getNextDumpPiece);
+        return;
+    }
+
+    putcUart0('L');
+    putcUart0('C');
+    putcUart0('R');
+    putcUart0('H');
+    crc = putDumpByte(crc, historyCount);
+    crc = putDumpByte(crc, historyCount >> 8);
+    crc = putDumpByte(crc, sizeof(HISTORY_RECORD));
+    crc = putDumpByte(crc, sizeof(HISTORY_RECORD) >> 8);
+    // The Cortex-M4 is little endian, so the records go out as they are in memory
+    for(i = 0; i < historyCount; i++)
+    {
+        uint8_t* bytes = (uint8_t*)getHistoryRecord(i);
+        for(j = 0; j < sizeof(HISTORY_RECORD); j++)
+            crc = putDumpByte(crc, bytes[j]);
+    }
+    putcUart0(crc & 0xFF);
+    putcUart0(crc >> 8);
+}
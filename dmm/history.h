@@ -0,0 +1,71 @@
+// History Library
+// Sarker Nadir Afridi Azmi
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Hardware configuration:
+// UART0 for the binary dump
+//
+// Dump frame, all fields little endian:
+//   'L' 'C' 'R' 'H'                  magic
+//   uint16_t count, uint16_t size    number of records and bytes per record
+//   HISTORY_RECORD records[count]    oldest first
+//   uint16_t crc                     CRC-16/CCITT (0x1021, start 0xFFFF) of everything after the magic
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef HISTORY_H_
+#define HISTORY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "measure.h"
+
+// Number of readings kept, must be a power of 2
+#define HISTORY_SIZE            256
+
+//-----------------------------------------------------------------------------
+// Structs
+//-----------------------------------------------------------------------------
+
+// 20 bytes a reading, the value is kept as well so stats don't have to redo the conversion
+typedef struct _HISTORY_RECORD
+{
+    uint32_t time;              // ms since start up, when the charge ended
+    uint32_t countLow;          // raw timer count, 48 bits is 78 days at 40 MHz (worked out from tau for a curve fit)
+    uint16_t countHigh;
+    uint16_t esr;               // mOhm, inductance only
+    int16_t temperature;        // 0.1 C
+    uint8_t type;               // MEASUREMENT_TYPE
+    uint8_t status;             // MEASUREMENT_STATUS
+    float value;                // Ohm, uF or uH
+} HISTORY_RECORD;
+
+typedef struct _HISTORY_STATS
+{
+    uint16_t count;
+    float min;
+    float max;
+    float mean;
+    float stddev;
+} HISTORY_STATS;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void addHistory(MEASUREMENT_RESULT* result);
+bool clearHistory();
+uint16_t getHistoryCount();
+bool getHistoryStats(MEASUREMENT_TYPE type, HISTORY_STATS* stats);
+void dumpHistory();
+
+#endif
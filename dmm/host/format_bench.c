@@ -0,0 +1,61 @@
+/*
+ * Format Benchmark
+ * Sarker Nadir Afridi Azmi
+ *
+ * Host program that checks formatEngineering() against sprintf("%.2f") and times both.
+ * This is not part of the firmware, build and run it on a PC from the dmm directory:
+ *
+ *   gcc -O2 -I. format.c host/format_bench.c -o format_bench && ./format_bench
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include "format.h"
+
+#define ITERATIONS 1000000
+
+// Typical readings, in base units
+const float values[] = {0.0f, 0.47f, 12.345f, 999.996f, 4700.0f, 1.5e6f, 22e-9f, 100e-12f, 1000e-6f, -3.3f};
+#define VALUE_COUNT (sizeof(values) / sizeof(values[0]))
+
+double getSeconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+int main(void)
+{
+    char str[100];
+    volatile char sink = 0;
+    uint32_t i;
+
+    for(i = 0; i < VALUE_COUNT; i++)
+    {
+        formatEngineering(str, values[i], "F");
+        printf("%-14g -> %s\n", values[i], str);
+    }
+
+    double start = getSeconds();
+    for(i = 0; i < ITERATIONS; i++)
+    {
+        formatEngineering(str, values[i % VALUE_COUNT], "Ohm");
+        sink += str[0];
+    }
+    double formatTime = getSeconds() - start;
+
+    start = getSeconds();
+    for(i = 0; i < ITERATIONS; i++)
+    {
+        sprintf(str, "%.2f Ohm", values[i % VALUE_COUNT]);
+        sink += str[0];
+    }
+    double sprintfTime = getSeconds() - start;
+
+    printf("formatEngineering: %.1f ns/call\n", formatTime * 1e9 / ITERATIONS);
+    printf("sprintf(\"%%.2f\"):   %.1f ns/call\n", sprintfTime * 1e9 / ITERATIONS);
+    printf("speedup:           %.1fx\n", sprintfTime / formatTime);
+    return 0;
+}
@@ -0,0 +1,1389 @@
+// Analog Front End Simulator
+// Sarker Nadir Afridi Azmi
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: Linux PC, host builds only
+// Simulated uC:    TM4C123GH6PM
+// System Clock:    40 MHz (simulated)
+
+// Hardware configuration:
+// Simulated: Timer 0-2, Wide Timer 0-1 (64-bit and 48-bit edge time too), ADC0, ADC1, Analog Comparator 0-1, UART0, SysTick,
+//            uDMA channel 9 (UART0 TX)
+// C0o is jumpered to WT1CCP0 and DUT2 to C1-, like on the board, C1+ sits at COMPARATOR1_VREF
+// DUT network, see simUpdateAnalog():
+//   DUT1 is driven to VSUPPLY by MEAS_LR or to ground by MEAS_C
+//   DUT2 is loaded by LOWSIDE_R (33 Ohm to ground), HIGHSIDE_R (to VSUPPLY)
+//   and the 1uF integrating capacitor (INTEGRATE)
+// The board values are worked out from the calibration constants in measure.h, so an
+// ideal part read with no latency gives its nominal value and what is left in a reading
+// is the error of the algorithm (latency, quantization, esr correction)
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <sys/mman.h>
+#include "tm4c123gh6pm.h"
+#include "gpio.h"
+#include "measure.h"
+#include "dma.h"
+#include "sim.h"
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE     0x100000
+#endif
+
+// The backing memory of a register, without going through simRegister()
+#define RAW(address)            (*((volatile uint32_t *)(uintptr_t)(address)))
+
+#define SIM_NEVER               UINT64_MAX
+#define SIM_MAX_HOOKS           96
+#define SIM_UART_BUFFER_SIZE    256
+#define SIM_UART_FIFO_SIZE      16
+
+// General purpose timer register offsets
+#define GPTM_CFG                0x000
+#define GPTM_TAMR               0x004
+#define GPTM_CTL                0x00C
+#define GPTM_IMR                0x018
+#define GPTM_RIS                0x01C
+#define GPTM_MIS                0x020
+#define GPTM_ICR                0x024
+#define GPTM_TAILR              0x028
+#define GPTM_TBILR              0x02C
+#define GPTM_TAPR               0x038
+#define GPTM_TAR                0x048
+#define GPTM_TBR                0x04C
+#define GPTM_TAV                0x050
+#define GPTM_TBV                0x054
+#define GPTM_TAPS               0x05C
+
+// ADC register offsets, n is the sample sequencer
+#define ADCREG_ACTSS            0x000
+#define ADCREG_RIS              0x004
+#define ADCREG_IM               0x008
+#define ADCREG_ISC              0x00C
+#define ADCREG_EMUX             0x014
+#define ADCREG_PSSI             0x028
+#define ADCREG_SAC              0x030
+#define ADCREG_SSMUX(n)         (0x040 + 0x20 * (n))
+#define ADCREG_SSCTL(n)         (0x044 + 0x20 * (n))
+#define ADCREG_SSFIFO(n)        (0x048u + 0x20u * (n))
+#define ADCREG_SSFSTAT(n)       (0x04Cu + 0x20u * (n))
+
+#define COMP_BASE               0x4003C000
+#define COMP_ACSTAT(n)          (COMP_BASE + 0x020 + 0x20 * (n))
+#define COMP_ACCTL(n)           (COMP_BASE + 0x024 + 0x20 * (n))
+#define SIM_COMPARATOR_COUNT    2
+#define UART0_BASE              0x4000C000
+
+// Comparator resistor ladder, from the datasheet table for VDDA = 3.3 V
+#define SIM_VREF_HIGH_BASE      0.731
+#define SIM_VREF_HIGH_STEP      0.1158
+#define SIM_VREF_LOW_STEP       0.1375
+
+// UART0_DR_R backing values, a write only ever stores a byte
+#define SIM_UART_DR_IDLE        0xFFFFFFFF
+#define SIM_UART_DR_READ        0x80000000
+
+//-----------------------------------------------------------------------------
+// Structs
+//-----------------------------------------------------------------------------
+
+typedef struct _SIM_TIMER
+{
+    uintptr_t base;
+    uint8_t vector;
+    bool isWide;
+    bool isRunning;
+    uint64_t startCycle;
+    uint64_t startValue;
+    uint32_t ris;
+} SIM_TIMER;
+
+typedef struct _SIM_ADC
+{
+    uintptr_t base;
+    uint8_t vector;
+    uint32_t ris;
+    uint16_t fifo[4][8];
+    uint8_t fifoCount[4];
+    uint64_t readyCycle;
+} SIM_ADC;
+
+// Voltages and currents that take time to change
+typedef struct _SIM_ANALOG
+{
+    double vIntegrator;
+    double vDut;
+    double iDut;
+} SIM_ANALOG;
+
+typedef struct _SIM_HOOK
+{
+    uintptr_t address;
+    uint32_t shadow;
+} SIM_HOOK;
+
+typedef struct _SIM_VECTOR
+{
+    uint8_t vector;
+    void (*isr)();
+} SIM_VECTOR;
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+// The firmware ISRs, a host program only links the ones it needs
+void comparator0Isr() __attribute__((weak));
+void comparator1Isr() __attribute__((weak));
+void wideTimer1Isr() __attribute__((weak));
+void timer1Isr() __attribute__((weak));
+void adc1Ss3Isr() __attribute__((weak));
+void systickIsr() __attribute__((weak));
+void uart0Isr() __attribute__((weak));
+
+// The uDMA control table of dma.c, CTLBASE only holds the lower half of a host address
+extern DMA_CONTROL dmaControlTable[] __attribute__((weak));
+
+// Keep in step with the vector table in tm4c123gh6pm_startup_ccs.c
+SIM_VECTOR simVectors[] =
+{
+    {.vector = INT_TIMER1A, .isr = timer1Isr},
+    {.vector = INT_COMP0, .isr = comparator0Isr},
+    {.vector = INT_COMP1, .isr = comparator1Isr},
+    {.vector = INT_ADC1SS3, .isr = adc1Ss3Isr},
+    {.vector = INT_WTIMER1A, .isr = wideTimer1Isr},
+    {.vector = INT_UART0, .isr = uart0Isr}
+};
+#define SIM_VECTOR_COUNT (sizeof(simVectors) / sizeof(simVectors[0]))
+
+SIM_TIMER simTimers[] =
+{
+    {.base = 0x40030000, .vector = INT_TIMER0A, .isWide = false, .isRunning = false, .startCycle = 0, .startValue = 0, .ris = 0},
+    {.base = 0x40031000, .vector = INT_TIMER1A, .isWide = false, .isRunning = false, .startCycle = 0, .startValue = 0, .ris = 0},
+    {.base = 0x40032000, .vector = INT_TIMER2A, .isWide = false, .isRunning = false, .startCycle = 0, .startValue = 0, .ris = 0},
+    {.base = 0x40036000, .vector = INT_WTIMER0A, .isWide = true, .isRunning = false, .startCycle = 0, .startValue = 0, .ris = 0},
+    {.base = 0x40037000, .vector = INT_WTIMER1A, .isWide = true, .isRunning = false, .startCycle = 0, .startValue = 0, .ris = 0}
+};
+#define SIM_TIMER_COUNT (sizeof(simTimers) / sizeof(simTimers[0]))
+// Wide Timer 1A, its CCP pin is jumpered to C0o
+#define SIM_CAPTURE_TIMER (&simTimers[4])
+
+SIM_ADC simAdcs[] =
+{
+    {.base = 0x40038000, .vector = INT_ADC0SS0, .ris = 0, .fifo = {{0}}, .fifoCount = {0}, .readyCycle = 0},
+    {.base = 0x40039000, .vector = INT_ADC1SS0, .ris = 0, .fifo = {{0}}, .fifoCount = {0}, .readyCycle = 0}
+};
+#define SIM_ADC_COUNT (sizeof(simAdcs) / sizeof(simAdcs[0]))
+const uint8_t simFifoDepth[4] = {8, 4, 4, 1};
+
+SIM_HOOK simHooks[SIM_MAX_HOOKS];
+uint8_t simHookCount = 0;
+
+uint64_t simCycles = 0;
+bool simIsInIsr = false;
+// Counts the ISRs run, an ISR that runs ends a WFI
+uint32_t simIsrCount = 0;
+// PRIMASK, nothing is dispatched while it is set
+bool simIsMasked = false;
+// Interrupts pended through NVIC_SW_TRIG_R, one bit per interrupt number (below 64)
+uint64_t simSoftwareTriggers = 0;
+// DWT_CYCCNT_R counts from here, it always runs (DEMCR and DWT_CTRL are ignored)
+uint64_t simCyccntBase = 0;
+
+SIM_DUT_TYPE simDutType = SIM_DUT_OPEN;
+double simDutValue = 0;
+double simDutEsr = 0;
+// Resistance of the fixture leads and the stray capacitance across the fixture, see simSetFixture()
+double simFixtureR = 0;
+double simFixtureC = 0;
+SIM_ANALOG simAnalog;
+
+double simNoiseLsb = 0;
+uint32_t simNoiseSeed = 1;
+double simTemperature = 25;
+// Every board value below drifts together by SIM_BOARD_TEMPCO_PPM per degree C from CALIBRATION_TEMP_C
+double simBoardDrift = 1;
+
+// Board values, worked out by simInit()
+double simIntegratorC = 1e-6;
+double simHighsideR = 100000;
+double simInductorScale = 1;
+
+// Bit n is comparator n
+uint32_t simComparatorOutputs = 0;
+uint32_t simComparatorRis = 0;
+
+bool simIsSystickRunning = false;
+bool simIsSystickPending = false;
+uint64_t simSystickNext = SIM_NEVER;
+
+char simUartRx[SIM_UART_BUFFER_SIZE];
+uint8_t simUartRxHead = 0;
+uint8_t simUartRxTail = 0;
+bool simIsUartEchoed = true;
+
+// Characters in the tx FIFO and the shift register, the oldest one is done at simUartTxDone
+uint8_t simUartTxCount = 0;
+uint64_t simUartTxDone = 0;
+char simUartLine[SIM_UART_BUFFER_SIZE];
+uint8_t simUartLineLength = 0;
+char simUartLastLine[SIM_UART_BUFFER_SIZE];
+
+// TXRIS, set when the tx FIFO drains past the IFLS level, cleared through UART0_ICR_R
+uint32_t simUartRis = 0;
+
+// uDMA channels turned on (ENASET) and done (CHIS), only UART0 TX is simulated
+uint32_t simDmaEnabled = 0;
+uint32_t simDmaDone = 0;
+
+// Characters that arrive later, see simReceiveUartAt()
+char simUartRxLater[SIM_UART_BUFFER_SIZE];
+uint64_t simUartRxCycle = SIM_NEVER;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+SIM_HOOK* simFindHook(uintptr_t address)
+{
+    uint8_t i;
+    for(i = 0; i < simHookCount; i++)
+        if(simHooks[i].address == address)
+            return &simHooks[i];
+    return 0;
+}
+
+// Writes a register the firmware may also write, without it looking like a firmware write
+void simSetRegister(uintptr_t address, uint32_t value)
+{
+    SIM_HOOK* hook = simFindHook(address);
+    RAW(address) = value;
+    if(hook != 0)
+        hook->shadow = value;
+}
+
+SIM_TIMER* simFindTimer(uintptr_t address)
+{
+    uint8_t i;
+    for(i = 0; i < SIM_TIMER_COUNT; i++)
+        if(simTimers[i].base == (address & ~0xFFF))
+            return &simTimers[i];
+    return 0;
+}
+
+SIM_ADC* simFindAdc(uintptr_t address)
+{
+    uint8_t i;
+    for(i = 0; i < SIM_ADC_COUNT; i++)
+        if(simAdcs[i].base == (address & ~0xFFF))
+            return &simAdcs[i];
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+// DUT network
+//-----------------------------------------------------------------------------
+
+double simRelax(double x, double target, double tau, double dt)
+{
+    if(tau <= 0)
+        return target;
+    return target + (x - target) * exp(-dt / tau);
+}
+
+/*
+ * Moves the DUT network dt seconds forward and returns DUT2
+ * The pins can't change during dt, so every node relaxes exponentially towards its target
+ * Everything on DUT2 except the DUT is summed up as a conductance g and a current i,
+ * DUT2 on its own would sit at i / g
+ */
+double simUpdateAnalog(SIM_ANALOG* a, double dt)
+{
+    bool isIntegrating = getPinValue(INTEGRATE);
+    bool isDut1Driven = getPinValue(MEAS_LR) || getPinValue(MEAS_C);
+    double v1 = getPinValue(MEAS_LR) ? VSUPPLY : 0;
+    double c = isIntegrating ? simIntegratorC * simBoardDrift : 0;
+    double highsideR = simHighsideR * simBoardDrift;
+    double g = 0;
+    double i = 0;
+    // The leads are in series with the part, the stray capacitance is across an open fixture or a capacitor
+    // (next to a resistor or an inductor it makes no difference)
+    SIM_DUT_TYPE type = (simDutType == SIM_DUT_OPEN && simFixtureC > 0) ? SIM_DUT_CAPACITOR : simDutType;
+    double value = (simDutType == SIM_DUT_OPEN) ? 0 : simDutValue;
+
+    if(type == SIM_DUT_RESISTOR)
+        value += simFixtureR;
+    else if(type == SIM_DUT_CAPACITOR)
+        value += simFixtureC;
+
+    if(getPinValue(LOWSIDE_R))
+        g += 1 / R33OHMS;
+    if(getPinValue(HIGHSIDE_R))
+    {
+        g += 1 / highsideR;
+        i += VSUPPLY / highsideR;
+    }
+
+    switch(type)
+    {
+        case SIM_DUT_RESISTOR:
+            if(isDut1Driven)
+            {
+                g += 1 / value;
+                i += v1 / value;
+            }
+            break;
+        case SIM_DUT_CAPACITOR:
+            // With DUT1 driven the DUT is one more capacitor from DUT2 to a fixed voltage
+            if(isDut1Driven)
+            {
+                double v2 = v1 + a->vDut;
+                if(g > 0)
+                    v2 = simRelax(v2, i / g, (c + value) / g, dt);
+                a->vDut = v2 - v1;
+                if(isIntegrating)
+                    a->vIntegrator = v2;
+                return v2;
+            }
+            break;
+        case SIM_DUT_INDUCTOR:
+            // DUT2 follows the inductor current, v2 = (iDut + i) / g
+            if(isDut1Driven && g > 0)
+            {
+                double r = 1 / g + simDutEsr + simFixtureR;
+                a->iDut = simRelax(a->iDut, (v1 - i / g) / r, (value * simInductorScale * simBoardDrift) / r, dt);
+                return (a->iDut + i) / g;
+            }
+            a->iDut = 0;
+            break;
+        default:
+            break;
+    }
+
+    if(isIntegrating)
+    {
+        if(g > 0)
+            a->vIntegrator = simRelax(a->vIntegrator, i / g, c / g, dt);
+        return a->vIntegrator;
+    }
+    return (g > 0) ? i / g : 0;
+}
+
+double simGetDut2Voltage()
+{
+    SIM_ANALOG a = simAnalog;
+    return simUpdateAnalog(&a, 0);
+}
+
+double simGetComparatorReference()
+{
+    uint32_t refctl = RAW(COMP_BASE + 0x010);
+    uint8_t step = refctl & COMP_ACREFCTL_VREF_M;
+
+    if(!(refctl & COMP_ACREFCTL_EN))
+        return 0;
+    if(refctl & COMP_ACREFCTL_RNG)
+        return step * SIM_VREF_LOW_STEP;
+    return SIM_VREF_HIGH_BASE + step * SIM_VREF_HIGH_STEP;
+}
+
+// Cn- is DUT2, Cn+ is the internal reference or the pin (the C1+ divider, a C0+ pin is not modelled)
+bool simGetComparatorOutput(uint8_t n, double dut2)
+{
+    uint32_t ctl = RAW(COMP_ACCTL(n));
+    double vplus = 0;
+    bool output;
+
+    if((ctl & COMP_ACCTL0_ASRCP_M) == COMP_ACCTL0_ASRCP_REF)
+        vplus = simGetComparatorReference();
+    else if((ctl & COMP_ACCTL0_ASRCP_M) == COMP_ACCTL0_ASRCP_PIN && n == 1)
+        vplus = COMPARATOR1_VREF;
+    output = vplus > dut2;
+    return (ctl & COMP_ACCTL0_CINV) ? !output : output;
+}
+
+// Comparator 0 counts as on once its reference is, comparator 1 once it is configured
+bool simIsComparatorOn(uint8_t n)
+{
+    if(n == 0)
+        return RAW(COMP_BASE + 0x010) & COMP_ACREFCTL_EN;
+    return RAW(COMP_ACCTL(n)) != 0;
+}
+
+uint32_t simGetComparatorOutputs(double dut2)
+{
+    uint32_t outputs = 0;
+    uint8_t n;
+    for(n = 0; n < SIM_COMPARATOR_COUNT; n++)
+        if(simIsComparatorOn(n) && simGetComparatorOutput(n, dut2))
+            outputs |= 1 << n;
+    return outputs;
+}
+
+/*
+ * Moves the analog side up to count cycles forward, returns the cycles actually taken
+ * The step is cut short at the first comparator transition, so the edge lands on the
+ * right cycle no matter how coarse the caller's steps are
+ */
+uint64_t simAdvanceAnalog(uint64_t count)
+{
+    SIM_ANALOG next = simAnalog;
+    double v = simUpdateAnalog(&next, (double)count / SIM_CLOCK_HZ);
+
+    if(simGetComparatorOutputs(v) != simComparatorOutputs)
+    {
+        uint64_t low = 0;
+        uint64_t high = count;
+        while(high - low > 1)
+        {
+            uint64_t middle = low + (high - low) / 2;
+            SIM_ANALOG trial = simAnalog;
+            if(simGetComparatorOutputs(simUpdateAnalog(&trial, (double)middle / SIM_CLOCK_HZ)) != simComparatorOutputs)
+                high = middle;
+            else
+                low = middle;
+        }
+        count = high;
+        next = simAnalog;
+        simUpdateAnalog(&next, (double)count / SIM_CLOCK_HZ);
+    }
+
+    simAnalog = next;
+    return count;
+}
+
+//-----------------------------------------------------------------------------
+// Timers
+//-----------------------------------------------------------------------------
+
+bool simIsTimerUp(SIM_TIMER* t)
+{
+    return RAW(t->base + GPTM_TAMR) & TIMER_TAMR_TACDIR;
+}
+
+bool simIsTimerCapture(SIM_TIMER* t)
+{
+    return (RAW(t->base + GPTM_TAMR) & TIMER_TAMR_TAMR_M) == TIMER_TAMR_TAMR_CAP;
+}
+
+// A wide timer configured as one 64-bit timer, TAV/TBV hold the lower/upper half
+bool simIsTimerConcatenated(SIM_TIMER* t)
+{
+    return t->isWide && (RAW(t->base + GPTM_CFG) & 0x7) == TIMER_CFG_32_BIT_TIMER;
+}
+
+// Bits in the count, a wide timer in edge time mode uses the prescaler as 16 more
+uint64_t simGetTimerMask(SIM_TIMER* t)
+{
+    if(simIsTimerConcatenated(t))
+        return UINT64_MAX;
+    if(t->isWide && simIsTimerCapture(t))
+        return 0xFFFFFFFFFFFFULL;
+    return 0xFFFFFFFF;
+}
+
+uint64_t simGetTimerLimit(SIM_TIMER* t)
+{
+    uint64_t limit = RAW(t->base + GPTM_TAILR);
+    if(simIsTimerConcatenated(t))
+        limit |= (uint64_t)RAW(t->base + GPTM_TBILR) << 32;
+    else if(t->isWide && simIsTimerCapture(t))
+        limit |= (uint64_t)(RAW(t->base + GPTM_TAPR) & 0xFFFF) << 32;
+    return limit;
+}
+
+// The count of a stopped timer is kept in TAV (and TBV)
+uint64_t simGetStoredTimerValue(SIM_TIMER* t)
+{
+    uint64_t value = RAW(t->base + GPTM_TAV);
+    if(simIsTimerConcatenated(t))
+        value |= (uint64_t)RAW(t->base + GPTM_TBV) << 32;
+    return value;
+}
+
+void simStoreTimerValue(SIM_TIMER* t, uint64_t value)
+{
+    simSetRegister(t->base + GPTM_TAV, (uint32_t)value);
+    if(simIsTimerConcatenated(t))
+        simSetRegister(t->base + GPTM_TBV, value >> 32);
+}
+
+uint64_t simGetTimerValue(SIM_TIMER* t)
+{
+    uint64_t elapsed;
+    if(!t->isRunning)
+        return simGetStoredTimerValue(t);
+    elapsed = simCycles - t->startCycle;
+    return (simIsTimerUp(t) ? t->startValue + elapsed : t->startValue - elapsed) & simGetTimerMask(t);
+}
+
+// Cycle of the next time-out, counting down it happens on the cycle after 0
+uint64_t simGetTimerEvent(SIM_TIMER* t)
+{
+    if(!t->isRunning || simIsTimerCapture(t))
+        return SIM_NEVER;
+    if(simIsTimerUp(t))
+    {
+        uint64_t limit = simGetTimerLimit(t);
+        // A 64-bit count does not run out in any simulation
+        if(limit < t->startValue || limit - t->startValue >= SIM_NEVER - t->startCycle - 1)
+            return SIM_NEVER;
+        return t->startCycle + (limit - t->startValue) + 1;
+    }
+    return t->startCycle + t->startValue + 1;
+}
+
+void simRunSequence(SIM_ADC* adc, uint8_t ss);
+
+// Timer triggered sample sequencers of every ADC
+void simTriggerAdcs()
+{
+    uint8_t i, ss;
+    for(i = 0; i < SIM_ADC_COUNT; i++)
+        for(ss = 0; ss < 4; ss++)
+            if(((RAW(simAdcs[i].base + ADCREG_EMUX) >> (4 * ss)) & 0xF) == (ADC_EMUX_EM3_TIMER >> 12))
+                simRunSequence(&simAdcs[i], ss);
+}
+
+void simTimeoutTimer(SIM_TIMER* t, uint64_t cycle)
+{
+    uint32_t ctl = RAW(t->base + GPTM_CTL);
+
+    t->ris |= TIMER_RIS_TATORIS;
+    if(ctl & TIMER_CTL_TAOTE)
+        simTriggerAdcs();
+
+    if((RAW(t->base + GPTM_TAMR) & TIMER_TAMR_TAMR_M) == TIMER_TAMR_TAMR_PERIOD)
+    {
+        t->startCycle = cycle;
+        t->startValue = simIsTimerUp(t) ? 0 : simGetTimerLimit(t);
+    }
+    else
+    {
+        // A one-shot timer turns itself off
+        t->isRunning = false;
+        simStoreTimerValue(t, simIsTimerUp(t) ? simGetTimerLimit(t) : 0);
+        simSetRegister(t->base + GPTM_CTL, ctl & ~TIMER_CTL_TAEN);
+    }
+}
+
+// Starts and stops the timers the firmware turned on or off
+void simUpdateTimers()
+{
+    uint8_t i;
+    for(i = 0; i < SIM_TIMER_COUNT; i++)
+    {
+        SIM_TIMER* t = &simTimers[i];
+        bool isEnabled = RAW(t->base + GPTM_CTL) & TIMER_CTL_TAEN;
+        if(isEnabled && !t->isRunning)
+        {
+            t->isRunning = true;
+            t->startCycle = simCycles;
+            t->startValue = simIsTimerUp(t) ? simGetStoredTimerValue(t) : simGetTimerLimit(t);
+        }
+        else if(!isEnabled && t->isRunning)
+        {
+            simStoreTimerValue(t, simGetTimerValue(t));
+            t->isRunning = false;
+        }
+    }
+}
+
+void simProcessTimerEvents()
+{
+    uint8_t i;
+    for(i = 0; i < SIM_TIMER_COUNT; i++)
+    {
+        uint64_t event;
+        while((event = simGetTimerEvent(&simTimers[i])) <= simCycles)
+            simTimeoutTimer(&simTimers[i], event);
+        if(RAW(simTimers[i].base + GPTM_RIS) != simTimers[i].ris)
+            simSetRegister(simTimers[i].base + GPTM_RIS, simTimers[i].ris);
+        RAW(simTimers[i].base + GPTM_MIS) = simTimers[i].ris & RAW(simTimers[i].base + GPTM_IMR);
+    }
+}
+
+// Edge time capture of C0o on Wide Timer 1A, the prescaler snapshot holds bits 32-47
+void simCaptureEdge(bool isRising)
+{
+    SIM_TIMER* t = SIM_CAPTURE_TIMER;
+    uint32_t event = RAW(t->base + GPTM_CTL) & TIMER_CTL_TAEVENT_M;
+
+    if(!t->isRunning || !simIsTimerCapture(t) || !(RAW(t->base + GPTM_TAMR) & TIMER_TAMR_TACMR))
+        return;
+    if(event == TIMER_CTL_TAEVENT_BOTH || (event == TIMER_CTL_TAEVENT_POS) == isRising)
+    {
+        uint64_t value = simGetTimerValue(t);
+        simSetRegister(t->base + GPTM_TAR, (uint32_t)value);
+        simSetRegister(t->base + GPTM_TAPS, (value >> 32) & 0xFFFF);
+        t->ris |= TIMER_RIS_CAERIS;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// ADC
+//-----------------------------------------------------------------------------
+
+// Uniform noise, noise LSB peak to peak
+double simGetNoise()
+{
+    if(simNoiseLsb == 0)
+        return 0;
+    simNoiseSeed = simNoiseSeed * 1103515245 + 12345;
+    return (((simNoiseSeed >> 8) & 0xFFFF) / 65536.0 - 0.5) * simNoiseLsb;
+}
+
+uint16_t simGetAdcCode(double v)
+{
+    double code = (v * 4096) / VSUPPLY + simGetNoise();
+    if(code < 0)
+        return 0;
+    if(code > 4095)
+        return 4095;
+    return (uint16_t)code;
+}
+
+double simGetAinVoltage(uint8_t input)
+{
+    switch(input)
+    {
+        case 1:
+            // Collector of Q3, the low side switch is ideal
+            return 0;
+        case 2:
+            // Collector of Q7, DUT1
+            return getPinValue(MEAS_LR) ? VSUPPLY : 0;
+        case 3:
+            return simGetDut2Voltage();
+        default:
+            return 0;
+    }
+}
+
+// Internal temperature sensor, TEMP = 147.5 - (75 * VREFP * ADCCODE) / 4096, so VTS = (147.5 - TEMP) / 75
+double simGetTemperatureVoltage()
+{
+    return (147.5 - simTemperature) / 75;
+}
+
+// Converts every step of a sample sequencer, the results are ready 1 us per sample later
+void simRunSequence(SIM_ADC* adc, uint8_t ss)
+{
+    uint32_t mux = RAW(adc->base + ADCREG_SSMUX(ss));
+    uint32_t ctl = RAW(adc->base + ADCREG_SSCTL(ss));
+    uint8_t averages = 1 << (RAW(adc->base + ADCREG_SAC) & 7);
+    uint8_t step, i;
+
+    if(!(RAW(adc->base + ADCREG_ACTSS) & (1 << ss)))
+        return;
+
+    for(step = 0; step < simFifoDepth[ss]; step++)
+    {
+        uint8_t control = (ctl >> (4 * step)) & 0xF;
+        double v = (control & ADC_SSCTL1_TS0) ? simGetTemperatureVoltage() : simGetAinVoltage((mux >> (4 * step)) & 0xF);
+        uint32_t sum = 0;
+        for(i = 0; i < averages; i++)
+            sum += simGetAdcCode(v);
+        if(adc->fifoCount[ss] < simFifoDepth[ss])
+            adc->fifo[ss][adc->fifoCount[ss]++] = sum / averages;
+        if(control & ADC_SSCTL1_IE0)
+            adc->ris |= 1 << ss;
+        if(control & ADC_SSCTL1_END0)
+            break;
+    }
+    adc->readyCycle = simCycles + (step + 1) * averages * (SIM_CLOCK_HZ / 1000000);
+}
+
+uint16_t simPopFifo(SIM_ADC* adc, uint8_t ss)
+{
+    uint16_t value;
+    uint8_t i;
+    if(adc->fifoCount[ss] == 0)
+        return 0;
+    value = adc->fifo[ss][0];
+    for(i = 1; i < adc->fifoCount[ss]; i++)
+        adc->fifo[ss][i - 1] = adc->fifo[ss][i];
+    adc->fifoCount[ss]--;
+    return value;
+}
+
+//-----------------------------------------------------------------------------
+// Comparator, SysTick and interrupts
+//-----------------------------------------------------------------------------
+
+// Called every time DUT2 or the pins may have moved
+void simUpdateComparator()
+{
+    uint32_t outputs = simGetComparatorOutputs(simGetDut2Voltage());
+    uint8_t n;
+
+    for(n = 0; n < SIM_COMPARATOR_COUNT; n++)
+    {
+        uint32_t ctl = RAW(COMP_ACCTL(n));
+        uint32_t isen = ctl & COMP_ACCTL0_ISEN_M;
+        uint32_t bit = 1 << n;
+        bool output = outputs & bit;
+
+        if(!simIsComparatorOn(n))
+            continue;
+        if(output != ((simComparatorOutputs & bit) != 0))
+        {
+            if(isen == COMP_ACCTL0_ISEN_BOTH || (isen == COMP_ACCTL0_ISEN_RISE && output) || (isen == COMP_ACCTL0_ISEN_FALL && !output))
+                simComparatorRis |= bit;
+            // Only C0o is jumpered to a capture pin
+            if(n == 0)
+                simCaptureEdge(output);
+        }
+        if(isen == COMP_ACCTL0_ISEN_LEVEL && output == ((ctl & COMP_ACCTL0_ISLVAL) != 0))
+            simComparatorRis |= bit;
+    }
+    simComparatorOutputs = outputs;
+}
+
+void simUpdateSystick()
+{
+    bool isEnabled = RAW(0xE000E010) & NVIC_ST_CTRL_ENABLE;
+    uint32_t period = (RAW(0xE000E014) & 0xFFFFFF) + 1;
+
+    if(isEnabled && !simIsSystickRunning)
+        simSystickNext = simCycles + period;
+    simIsSystickRunning = isEnabled;
+    if(!isEnabled)
+        return;
+
+    while(simSystickNext <= simCycles)
+    {
+        if(RAW(0xE000E010) & NVIC_ST_CTRL_INTEN)
+            simIsSystickPending = true;
+        simSystickNext += period;
+    }
+}
+
+bool simIsIrqEnabled(uint8_t vector)
+{
+    uint8_t n = vector - 16;
+    return RAW(0xE000E100 + 4 * (n / 32)) & (1u << (n % 32));
+}
+
+bool simIsIrqPending(uint8_t vector)
+{
+    uint8_t i;
+
+    if(simSoftwareTriggers & (1ULL << (vector - 16)))
+        return true;
+    // The receive interrupts are taken as level, on as long as anything is waiting in the FIFO
+    if(vector == INT_UART0 && (simDmaDone & (1 << DMA_CHANNEL_UART0_TX)))
+        return true;
+    if(vector == INT_UART0)
+        return (simUartRis | ((simUartRxHead != simUartRxTail) ? UART_RIS_RXRIS | UART_RIS_RTRIS : 0)) & RAW(UART0_BASE + 0x038);
+    if(vector == INT_COMP0 || vector == INT_COMP1)
+        return simComparatorRis & RAW(COMP_BASE + 0x008) & (1 << (vector - INT_COMP0));
+    for(i = 0; i < SIM_TIMER_COUNT; i++)
+        if(simTimers[i].vector == vector)
+            return simTimers[i].ris & RAW(simTimers[i].base + GPTM_IMR);
+    for(i = 0; i < SIM_ADC_COUNT; i++)
+        if(vector >= simAdcs[i].vector && vector < simAdcs[i].vector + 4)
+            return simAdcs[i].ris & RAW(simAdcs[i].base + ADCREG_IM) & (1 << (vector - simAdcs[i].vector));
+    return false;
+}
+
+void simEnterIsr(void (*isr)())
+{
+    simIsInIsr = true;
+    simIsrCount++;
+    simAdvance(SIM_ISR_ENTRY_CYCLES);
+    isr();
+    simIsInIsr = false;
+}
+
+void simCheckWrites();
+
+// True if an enabled interrupt is waiting to be taken
+bool simIsInterruptPending()
+{
+    uint8_t i;
+
+    if(simIsSystickPending && systickIsr)
+        return true;
+    for(i = 0; i < SIM_VECTOR_COUNT; i++)
+    {
+        if(simVectors[i].isr && simIsIrqEnabled(simVectors[i].vector) && simIsIrqPending(simVectors[i].vector))
+            return true;
+    }
+    return false;
+}
+
+// Runs every pending ISR, there is no nesting so an ISR runs to completion
+void simDispatchInterrupts()
+{
+    bool isDispatched = true;
+    uint8_t i;
+
+    if(simIsInIsr || simIsMasked)
+        return;
+
+    while(isDispatched)
+    {
+        isDispatched = false;
+        if(simIsSystickPending && systickIsr)
+        {
+            simIsSystickPending = false;
+            simEnterIsr(systickIsr);
+            isDispatched = true;
+        }
+        for(i = 0; i < SIM_VECTOR_COUNT && !isDispatched; i++)
+        {
+            if(simVectors[i].isr && simIsIrqEnabled(simVectors[i].vector) && simIsIrqPending(simVectors[i].vector))
+            {
+                simSoftwareTriggers &= ~(1ULL << (simVectors[i].vector - 16));
+                simEnterIsr(simVectors[i].isr);
+                isDispatched = true;
+            }
+        }
+        // The ISR has to clear its flags before anything is found pending again
+        if(isDispatched)
+            simCheckWrites();
+    }
+}
+
+//-----------------------------------------------------------------------------
+// UART
+//-----------------------------------------------------------------------------
+
+void simReceiveUart(const char* str);
+void simTransmitUart(char c);
+
+// System clocks to shift out one character (start, 8 data and stop bit) at the programmed rate
+// A bit is 16 ticks of the divided clock, or 8 in high speed mode
+// Before the baud rate is set the UART sends in no time
+uint64_t simGetUartCharacterCycles()
+{
+    uint32_t ibrd = RAW(UART0_BASE + 0x024);
+    uint32_t fbrd = RAW(UART0_BASE + 0x028);
+    uint32_t ticks = (RAW(UART0_BASE + 0x030) & UART_CTL_HSE) ? 8 : 16;
+    return (10 * ticks * (64ULL * ibrd + fbrd)) / 64;
+}
+
+// Characters in the tx FIFO, the one in the shift register is not counted
+uint8_t simGetUartFifoCount()
+{
+    return simUartTxCount > 0 ? simUartTxCount - 1 : 0;
+}
+
+// Channel 9 puts bytes into the tx FIFO while there is room and UART0 asks for them
+void simUpdateDma()
+{
+    uint32_t bit = 1 << DMA_CHANNEL_UART0_TX;
+    DMA_CONTROL* entry;
+
+    if(!dmaControlTable)
+        return;
+    entry = &dmaControlTable[DMA_CHANNEL_UART0_TX];
+    while((simDmaEnabled & bit) && (RAW(UART0_BASE + 0x048) & UART_DMACTL_TXDMAE) && simUartTxCount <= SIM_UART_FIFO_SIZE)
+    {
+        uint32_t remaining = ((entry->control & UDMA_CHCTL_XFERSIZE_M) >> UDMA_CHCTL_XFERSIZE_S) + 1;
+        simTransmitUart(*(uint8_t*)(entry->sourceEnd - (remaining - 1)));
+        if(remaining > 1)
+            entry->control -= 1 << UDMA_CHCTL_XFERSIZE_S;
+        else
+        {
+            entry->control &= ~(UDMA_CHCTL_XFERSIZE_M | UDMA_CHCTL_XFERMODE_M);
+            simDmaEnabled &= ~bit;
+            simDmaDone |= bit;
+            // So the next write of the same bit is seen as one
+            simSetRegister(0x400FF028, simDmaEnabled);
+        }
+    }
+}
+
+void simUpdateUart()
+{
+    // TXIFLSEL 1/8, 1/4, 1/2, 3/4 and 7/8 of the FIFO
+    const uint8_t levels[] = {2, 4, 8, 12, 14};
+    uint8_t level = levels[RAW(UART0_BASE + 0x034) & UART_IFLS_TX_M];
+    uint64_t cycles = simGetUartCharacterCycles();
+    while(simUartTxCount > 0 && simCycles >= simUartTxDone)
+    {
+        if(simGetUartFifoCount() == level + 1)
+            simUartRis |= UART_RIS_TXRIS;
+        simUartTxCount--;
+        simUartTxDone += cycles;
+    }
+    simUpdateDma();
+    if(simCycles >= simUartRxCycle)
+    {
+        simUartRxCycle = SIM_NEVER;
+        simReceiveUart(simUartRxLater);
+    }
+}
+
+void simTransmitUart(char c)
+{
+    uint64_t cycles = simGetUartCharacterCycles();
+    if(cycles > 0)
+    {
+        if(simUartTxCount == 0)
+            simUartTxDone = simCycles + cycles;
+        simUartTxCount++;
+    }
+
+    if(c == '\n')
+    {
+        simUartLine[simUartLineLength] = '\0';
+        snprintf(simUartLastLine, SIM_UART_BUFFER_SIZE, "%s", simUartLine);
+        simUartLineLength = 0;
+    }
+    else if(simUartLineLength < SIM_UART_BUFFER_SIZE - 1)
+        simUartLine[simUartLineLength++] = c;
+
+    if(simIsUartEchoed)
+        putchar(c);
+}
+
+//-----------------------------------------------------------------------------
+// Register access
+//-----------------------------------------------------------------------------
+
+// A firmware write to a register with side effects
+void simOnWrite(uintptr_t address, uint32_t value)
+{
+    SIM_TIMER* t = simFindTimer(address);
+    SIM_ADC* adc = simFindAdc(address);
+    uint8_t ss;
+
+    if(t != 0)
+    {
+        switch(address & 0xFFF)
+        {
+            case GPTM_TAV:
+                if(t->isRunning)
+                {
+                    t->startValue = (simGetTimerValue(t) & ~0xFFFFFFFFULL) | value;
+                    t->startCycle = simCycles;
+                }
+                break;
+            case GPTM_TBV:
+                if(t->isRunning && simIsTimerConcatenated(t))
+                {
+                    t->startValue = (simGetTimerValue(t) & 0xFFFFFFFF) | ((uint64_t)value << 32);
+                    t->startCycle = simCycles;
+                }
+                break;
+            case GPTM_TAILR:
+                // Counting down, a new load value takes effect straight away
+                if(t->isRunning && !simIsTimerUp(t) && !simIsTimerCapture(t))
+                {
+                    t->startCycle = simCycles;
+                    t->startValue = value;
+                }
+                break;
+            case GPTM_ICR:
+                t->ris &= ~value;
+                simSetRegister(address, 0);
+                break;
+        }
+    }
+    else if(adc != 0)
+    {
+        switch(address & 0xFFF)
+        {
+            case ADCREG_PSSI:
+                for(ss = 0; ss < 4; ss++)
+                    if(value & (1 << ss))
+                        simRunSequence(adc, ss);
+                simSetRegister(address, 0);
+                break;
+            case ADCREG_ISC:
+                adc->ris &= ~value;
+                simSetRegister(address, 0);
+                break;
+        }
+    }
+    else if(address == COMP_BASE)
+    {
+        // ACMIS, write 1 to clear
+        simComparatorRis &= ~value;
+        simSetRegister(address, 0);
+    }
+    else if(address == 0xE000E018)
+    {
+        // Any write to ST_CURRENT restarts the count
+        simSystickNext = simCycles + (RAW(0xE000E014) & 0xFFFFFF) + 1;
+        simSetRegister(address, 0);
+    }
+    else if(address == 0xE0001004)
+        simCyccntBase = simCycles - value;
+    else if(address == UART0_BASE + 0x044)
+    {
+        simUartRis &= ~value;
+        simSetRegister(address, 0);
+    }
+    else if(address == 0x400FF028)
+    {
+        // UDMA_ENASET and ENACLR, write 1 to set or clear
+        simDmaEnabled |= value;
+        simSetRegister(address, simDmaEnabled);
+    }
+    else if(address == 0x400FF02C)
+    {
+        simDmaEnabled &= ~value;
+        simSetRegister(address, 0);
+    }
+    else if(address == 0x400FF504)
+    {
+        // UDMA_CHIS, write 1 to clear, it always reads 0 so every write is seen
+        simDmaDone &= ~value;
+        simSetRegister(address, 0);
+    }
+    else if(address == 0xE000EF00)
+    {
+        if(value < 64)
+            simSoftwareTriggers |= 1ULL << value;
+        simSetRegister(address, 0);
+    }
+}
+
+// UART0_DR_R is both a read (pops the receive FIFO) and a write (transmits)
+void simCheckUartData(SIM_HOOK* hook)
+{
+    uint32_t value = RAW(hook->address);
+    if(value != hook->shadow)
+        simTransmitUart(value & 0xFF);
+    else if(hook->shadow == SIM_UART_DR_IDLE)
+        return;
+    else if(simUartRxHead != simUartRxTail)
+        simUartRxTail = (simUartRxTail + 1) % SIM_UART_BUFFER_SIZE;
+    simSetRegister(hook->address, SIM_UART_DR_IDLE);
+}
+
+// Finds the writes made since the last access, the firmware writes are just stores to memory
+void simCheckWrites()
+{
+    uint8_t i;
+    for(i = 0; i < simHookCount; i++)
+    {
+        SIM_HOOK* hook = &simHooks[i];
+        uint32_t value = RAW(hook->address);
+        if(hook->address == UART0_BASE)
+            simCheckUartData(hook);
+        else if(value != hook->shadow)
+        {
+            hook->shadow = value;
+            simOnWrite(hook->address, value);
+        }
+    }
+}
+
+// Puts the current value of a register in memory right before the firmware reads it
+void simPrepareRead(uintptr_t address)
+{
+    SIM_TIMER* t = simFindTimer(address);
+    SIM_ADC* adc = simFindAdc(address);
+    uint8_t ss;
+
+    if(t != 0)
+    {
+        switch(address & 0xFFF)
+        {
+            case GPTM_TAV:
+                RAW(address) = simGetTimerValue(t);
+                break;
+            case GPTM_TBV:
+                if(simIsTimerConcatenated(t))
+                    RAW(address) = simGetTimerValue(t) >> 32;
+                break;
+            case GPTM_TAR:
+                if(!simIsTimerCapture(t))
+                    RAW(address) = simGetTimerValue(t);
+                break;
+            case GPTM_TBR:
+                if(simIsTimerConcatenated(t))
+                    RAW(address) = simGetTimerValue(t) >> 32;
+                break;
+        }
+    }
+    else if(adc != 0)
+    {
+        uint32_t offset = address & 0xFFF;
+        if(offset == ADCREG_ACTSS)
+        {
+            if(simCycles < adc->readyCycle)
+                RAW(address) |= ADC_ACTSS_BUSY;
+            else
+                RAW(address) &= ~ADC_ACTSS_BUSY;
+        }
+        else if(offset == ADCREG_RIS)
+            RAW(address) = adc->ris;
+        for(ss = 0; ss < 4; ss++)
+        {
+            if(offset == ADCREG_SSFIFO(ss))
+                RAW(address) = simPopFifo(adc, ss);
+            else if(offset == ADCREG_SSFSTAT(ss))
+                RAW(address) = (adc->fifoCount[ss] == 0) ? ADC_SSFSTAT3_EMPTY : 0;
+        }
+    }
+    else if(address == COMP_BASE + 0x004)
+        RAW(address) = simComparatorRis;
+    else if(address == COMP_ACSTAT(0))
+        RAW(address) = (simComparatorOutputs & 1) ? COMP_ACSTAT0_OVAL : 0;
+    else if(address == COMP_ACSTAT(1))
+        RAW(address) = (simComparatorOutputs & 2) ? COMP_ACSTAT1_OVAL : 0;
+    else if(address == UART0_BASE)
+        RAW(address) = SIM_UART_DR_READ | ((simUartRxHead != simUartRxTail) ? (uint8_t)simUartRx[simUartRxTail] : 0);
+    else if(address == UART0_BASE + 0x018)
+    {
+        RAW(address) = (simUartRxHead == simUartRxTail) ? UART_FR_RXFE : 0;
+        if(simUartTxCount == 0)
+            RAW(address) |= UART_FR_TXFE;
+        else
+            RAW(address) |= UART_FR_BUSY;
+        // The shift register holds one more character than the FIFO
+        if(simUartTxCount > SIM_UART_FIFO_SIZE)
+            RAW(address) |= UART_FR_TXFF;
+    }
+    else if(address == 0xE000E018)
+        RAW(address) = simIsSystickRunning ? (uint32_t)(simSystickNext - simCycles - 1) : 0;
+    else if(address == 0xE0001004)
+        RAW(address) = (uint32_t)(simCycles - simCyccntBase);
+    else if(address == 0x400FF028)
+        RAW(address) = simDmaEnabled;
+}
+
+/*
+ * Every access to a register listed in sim_registers.h lands here
+ * The writes made since the last access are handled first, then time moves on by
+ * SIM_ACCESS_CYCLES and the register gets its current value
+ * There is no way to tell a read from a write, so writes are found afterwards by
+ * comparing the memory with what was last put there (simCheckWrites())
+ */
+volatile uint32_t* simRegister(uintptr_t address)
+{
+    SIM_HOOK* hook = simFindHook(address);
+    if(hook == 0)
+    {
+        if(simHookCount == SIM_MAX_HOOKS)
+        {
+            fprintf(stderr, "sim: too many registers\n");
+            exit(1);
+        }
+        hook = &simHooks[simHookCount++];
+        hook->address = address;
+        hook->shadow = RAW(address);
+    }
+
+    simAdvance(SIM_ACCESS_CYCLES);
+    simPrepareRead(address);
+    hook->shadow = RAW(address);
+    return &RAW(address);
+}
+
+//-----------------------------------------------------------------------------
+// Time
+//-----------------------------------------------------------------------------
+
+uint64_t simGetNextEvent()
+{
+    uint64_t next = simIsSystickRunning ? simSystickNext : SIM_NEVER;
+    uint8_t i;
+    for(i = 0; i < SIM_TIMER_COUNT; i++)
+    {
+        uint64_t event = simGetTimerEvent(&simTimers[i]);
+        if(event < next)
+            next = event;
+    }
+    // Each character sent can be the one that raises the transmit interrupt
+    if(simUartTxCount > 0 && ((RAW(UART0_BASE + 0x038) & UART_IM_TXIM) || simDmaEnabled) && simUartTxDone < next)
+        next = simUartTxDone;
+    if(simUartRxCycle < next)
+        next = simUartRxCycle;
+    return next;
+}
+
+// Brings the board up to simCycles and runs the interrupts that are pending
+void simUpdate()
+{
+    simCheckWrites();
+    simUpdateTimers();
+    simUpdateSystick();
+    simUpdateComparator();
+    simUpdateUart();
+    simProcessTimerEvents();
+    simDispatchInterrupts();
+}
+
+// Moves time on to the next timer event or comparator edge, no further than end
+void simStep(uint64_t end)
+{
+    uint64_t next = simGetNextEvent();
+    if(next > end)
+        next = end;
+    if(next <= simCycles)
+        next = simCycles + 1;
+    simCycles += simAdvanceAnalog(next - simCycles);
+}
+
+/*
+ * Runs the simulated board for count system clocks
+ * Time only moves in here and in simWaitForInterrupt(); steps end on every timer event and comparator edge,
+ * and pending interrupts run in between (the ISR itself can't be interrupted)
+ */
+void simAdvance(uint32_t count)
+{
+    uint64_t end = simCycles + count;
+
+    simUpdate();
+    while(simCycles < end)
+    {
+        simStep(end);
+        simUpdate();
+    }
+}
+
+// WFI, runs the board until an interrupt is pending, masked or not, or one has run
+// Nothing can wake the core with every timer off, so that stops after a millisecond instead of hanging
+void simWaitForInterrupt()
+{
+    uint64_t start = simCycles;
+    uint64_t end = simCycles + SIM_CLOCK_HZ / 1000;
+    uint32_t isrCount = simIsrCount;
+
+    simUpdate();
+    while(!simIsInterruptPending() && simIsrCount == isrCount && simCycles < end)
+    {
+        simStep(end);
+        simUpdate();
+    }
+    // A pending interrupt still takes the core a cycle to wake
+    if(simCycles == start)
+        simAdvance(1);
+}
+
+// CPSID I and CPSIE I, whatever became pending while masked runs on the next cycle
+void simDisableInterrupts()
+{
+    simIsMasked = true;
+}
+
+void simEnableInterrupts()
+{
+    simIsMasked = false;
+    simAdvance(1);
+}
+
+uint64_t simGetCycles()
+{
+    return simCycles;
+}
+
+//-----------------------------------------------------------------------------
+// Setup
+//-----------------------------------------------------------------------------
+
+void simMapRegion(uintptr_t address, size_t size)
+{
+    void* p = mmap((void*)address, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if(p != (void*)address)
+    {
+        fprintf(stderr, "sim: can't map the registers at 0x%08lx\n", (unsigned long)address);
+        exit(1);
+    }
+}
+
+// Maps the peripherals, the bit-band alias and the core peripherals, then sets the reset values
+void simInit()
+{
+    uint8_t i;
+    double k;
+
+    simMapRegion(0x40000000, 0x00100000);
+    simMapRegion(0x42000000, 0x02000000);
+    simMapRegion(0xE0000000, 0x00010000);
+
+    for(i = 0; i < SIM_TIMER_COUNT; i++)
+        RAW(simTimers[i].base + GPTM_TAILR) = 0xFFFFFFFF;
+    for(i = 0; i < SIM_ADC_COUNT; i++)
+    {
+        RAW(simAdcs[i].base + ADCREG_SSFSTAT(0)) = ADC_SSFSTAT3_EMPTY;
+        RAW(simAdcs[i].base + ADCREG_SSFSTAT(1)) = ADC_SSFSTAT3_EMPTY;
+        RAW(simAdcs[i].base + ADCREG_SSFSTAT(2)) = ADC_SSFSTAT3_EMPTY;
+        RAW(simAdcs[i].base + ADCREG_SSFSTAT(3)) = ADC_SSFSTAT3_EMPTY;
+    }
+    RAW(UART0_BASE) = SIM_UART_DR_IDLE;
+    RAW(UART0_BASE + 0x018) = UART_FR_TXFE | UART_FR_RXFE;
+
+    // Charge time to the comparator reference in time constants, with the VREF_M ladder tap
+    k = log(VSUPPLY / (VSUPPLY - (SIM_VREF_HIGH_BASE + 15 * SIM_VREF_HIGH_STEP)));
+    simIntegratorC = RESISTANCE_CONST / (SIM_CLOCK_HZ * k);
+    simHighsideR = CAPACITANCE_CONST / (SIM_CLOCK_HZ * 1e-6 * k);
+    simInductorScale = (INDUCTANCE_CONST * 1e6 * R33OHMS) / (SIM_CLOCK_HZ * k);
+}
+
+// Puts a discharged part in the fixture, value in Ohm, F or H, esr only matters for inductors
+void simSetDut(SIM_DUT_TYPE type, double value, double esr)
+{
+    simDutType = type;
+    simDutValue = value;
+    simDutEsr = esr;
+    simAnalog.vDut = 0;
+    simAnalog.iDut = 0;
+}
+
+// Leads of leadR Ohm in series with the part and strayC F across the fixture, both 0 until this is called
+void simSetFixture(double leadR, double strayC)
+{
+    simFixtureR = leadR;
+    simFixtureC = strayC;
+}
+
+void simSetNoise(double lsb)
+{
+    simNoiseLsb = lsb;
+}
+
+void simSetTemperature(double celsius)
+{
+    simTemperature = celsius;
+    simBoardDrift = 1 + SIM_BOARD_TEMPCO_PPM * 1e-6 * (celsius - CALIBRATION_TEMP_C);
+}
+
+void simSetUartEcho(bool enabled)
+{
+    simIsUartEchoed = enabled;
+}
+
+// Queues characters for the firmware to read from UART0
+void simReceiveUart(const char* str)
+{
+    while(*str != '\0')
+    {
+        uint8_t next = (simUartRxHead + 1) % SIM_UART_BUFFER_SIZE;
+        if(next == simUartRxTail)
+            return;
+        simUartRx[simUartRxHead] = *str++;
+        simUartRxHead = next;
+    }
+}
+
+// Queues characters for the firmware to read from UART0 once the simulation reaches cycle
+void simReceiveUartAt(uint64_t cycle, const char* str)
+{
+    snprintf(simUartRxLater, SIM_UART_BUFFER_SIZE, "%s", str);
+    simUartRxCycle = cycle;
+}
+
+// The last line the firmware sent, without the newline
+const char* simGetUartLine()
+{
+    return simUartLastLine;
+}
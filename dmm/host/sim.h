@@ -0,0 +1,68 @@
+// Analog Front End Simulator
+// Sarker Nadir Afridi Azmi
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: Linux PC, host builds only
+// Simulated uC:    TM4C123GH6PM
+// System Clock:    40 MHz (simulated)
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef SIM_H_
+#define SIM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SIM_CLOCK_HZ            40000000
+
+// System clocks charged for every access to a register with side effects
+#define SIM_ACCESS_CYCLES       4
+// Drift of the simulated board, the integrating capacitor, the high side resistor and the inductor
+// time constant all move by this much per degree C
+#define SIM_BOARD_TEMPCO_PPM    200
+
+// Exception entry, from the event to the first instruction of the ISR
+#define SIM_ISR_ENTRY_CYCLES    12
+
+//-----------------------------------------------------------------------------
+// Structs
+//-----------------------------------------------------------------------------
+
+typedef enum _SIM_DUT_TYPE
+{
+    SIM_DUT_OPEN,
+    SIM_DUT_RESISTOR,
+    SIM_DUT_CAPACITOR,
+    SIM_DUT_INDUCTOR
+} SIM_DUT_TYPE;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void simInit();
+void simSetDut(SIM_DUT_TYPE type, double value, double esr);
+void simSetFixture(double leadR, double strayC);
+void simSetNoise(double lsb);
+void simSetTemperature(double celsius);
+void simSetUartEcho(bool enabled);
+void simReceiveUart(const char* str);
+void simReceiveUartAt(uint64_t cycle, const char* str);
+const char* simGetUartLine();
+
+void simAdvance(uint32_t cycles);
+void simWaitForInterrupt();
+void simDisableInterrupts();
+void simEnableInterrupts();
+uint64_t simGetCycles();
+double simGetDut2Voltage();
+
+volatile uint32_t* simRegister(uintptr_t address);
+
+#endif
@@ -0,0 +1,544 @@
+/*
+ * Measurement Benchmark
+ * Sarker Nadir Afridi Azmi
+ *
+ * Host program that runs the measurement engine against the simulated front end (sim.c)
+ * and reports, for a set of parts, the reading, its error, the time to the first reading
+ * after the part goes in and the readings/sec after that, all in simulated time
+ * This is not part of the firmware, build and run it on a Linux PC from the dmm directory:
+ *
+ *   gcc -O2 -DSIMULATOR -I. -include host/sim_registers.h -Wno-int-to-pointer-cast \
+ *       measure.c fit.c adc0.c gpio.c clock.c wait.c uart0.c dma.c format.c stream.c history.c profile.c scheduler.c \
+ *       host/sim.c host/sim_bench.c -lm -o sim_bench && ./sim_bench
+ *
+ * Options: -hw (hardware capture), -fixed (fixed discharge), -fit (capacitance curve fit),
+ *          -auto (auto mode, adds 470 uF and 1000 uF read once), -n <readings per part>, -noise <ADC noise, LSB peak to peak>,
+ *          -dual (dual threshold timing), -faults (open, short and over-range fixtures instead of the parts),
+ *          -stream <seconds> (runs the stream task on each part, results going out at 115200 baud),
+ *          -baud <rate> (baud rate of the stream instead),
+ *          -fixture (0.2 Ohm leads and 10 pF stray capacitance on the fixture),
+ *          -zero (zeroes the fixture open and shorted before the parts),
+ *          with either one 0.5 Ohm and 100 pF are read once at the end, they need the zero to come out right,
+ *          -temp <degrees C> (board temperature), -tempco (compensate for the drift of the simulated board,
+ *          and show what the compensation takes off a 1 kOhm, 1 uF and 1 mH reading)
+ * Add -DPROFILE to the build for the cycle counts of every phase at the end of the run
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "adc0.h"
+#include "fit.h"
+#include "measure.h"
+#include "uart0.h"
+#include "wait.h"
+#include "stream.h"
+#include "profile.h"
+#include "scheduler.h"
+#include "host/sim.h"
+
+// What one pass of the main loop costs besides stepMeasurement()
+#define MAIN_LOOP_CYCLES        100
+// Give up on a reading after 400 s of simulated time, past the longest timeout of the firmware
+#define READING_TIMEOUT         (400ULL * SIM_CLOCK_HZ)
+#define MAX_READINGS            100
+
+typedef struct _BENCH_PART
+{
+    SIM_DUT_TYPE type;
+    double value;
+    double esr;
+    const char* name;
+} BENCH_PART;
+
+const BENCH_PART parts[] =
+{
+    {SIM_DUT_RESISTOR, 100, 0, "100 Ohm"},
+    {SIM_DUT_RESISTOR, 1e3, 0, "1 kOhm"},
+    {SIM_DUT_RESISTOR, 10e3, 0, "10 kOhm"},
+    {SIM_DUT_RESISTOR, 100e3, 0, "100 kOhm"},
+    {SIM_DUT_RESISTOR, 1e6, 0, "1 MOhm"},
+    {SIM_DUT_CAPACITOR, 10e-9, 0, "10 nF"},
+    {SIM_DUT_CAPACITOR, 100e-9, 0, "100 nF"},
+    {SIM_DUT_CAPACITOR, 1e-6, 0, "1 uF"},
+    {SIM_DUT_CAPACITOR, 10e-6, 0, "10 uF"},
+    {SIM_DUT_CAPACITOR, 100e-6, 0, "100 uF"},
+    {SIM_DUT_INDUCTOR, 100e-6, 0.5, "100 uH 0.5 Ohm"},
+    {SIM_DUT_INDUCTOR, 1e-3, 2, "1 mH 2 Ohm"},
+    {SIM_DUT_INDUCTOR, 10e-3, 5, "10 mH 5 Ohm"}
+};
+#define PART_COUNT (sizeof(parts) / sizeof(parts[0]))
+
+// Capacitors too slow for the LR classification burst, only run in auto mode and read once,
+// a reading takes a minute or two of simulated time
+const BENCH_PART largeParts[] =
+{
+    {SIM_DUT_CAPACITOR, 470e-6, 0, "470 uF"},
+    {SIM_DUT_CAPACITOR, 1e-3, 0, "1000 uF"}
+};
+#define LARGE_PART_COUNT (sizeof(largeParts) / sizeof(largeParts[0]))
+
+// Parts a value threshold used to take for a short or an open, read with -fixture or -zero
+// They have to come out within SMALL_PART_COUNTS counts, which takes a zeroed fixture once it has leads
+const BENCH_PART smallParts[] =
+{
+    {SIM_DUT_RESISTOR, 0.5, 0, "0.5 Ohm"},
+    {SIM_DUT_CAPACITOR, 100e-12, 0, "100 pF"}
+};
+#define SMALL_PART_COUNT (sizeof(smallParts) / sizeof(smallParts[0]))
+#define SMALL_PART_COUNTS       2
+
+// The fixture of -fixture, leads in series with the part and stray capacitance across it
+#define FIXTURE_LEAD_OHMS       0.2
+#define FIXTURE_STRAY_F         10e-12
+
+typedef struct _BENCH_FAULT
+{
+    MEASUREMENT_TYPE type;
+    SIM_DUT_TYPE dut;
+    double value;
+    double esr;
+    const char* name;
+    MEASUREMENT_STATUS expected;
+} BENCH_FAULT;
+
+const BENCH_FAULT faults[] =
+{
+    {MEASURE_RESISTANCE, SIM_DUT_OPEN, 0, 0, "R open", RESULT_OPEN},
+    {MEASURE_RESISTANCE, SIM_DUT_RESISTOR, 0.01, 0, "R short", RESULT_SHORT},
+    {MEASURE_RESISTANCE, SIM_DUT_RESISTOR, 20e6, 0, "R 20 MOhm", RESULT_OVER_RANGE},
+    {MEASURE_CAPACITANCE, SIM_DUT_OPEN, 0, 0, "C open", RESULT_OPEN},
+    {MEASURE_CAPACITANCE, SIM_DUT_RESISTOR, 0.01, 0, "C short", RESULT_SHORT},
+    {MEASURE_CAPACITANCE, SIM_DUT_CAPACITOR, 4.7e-3, 0, "C 4700 uF", RESULT_OVER_RANGE},
+    {MEASURE_INDUCTANCE, SIM_DUT_OPEN, 0, 0, "L open", RESULT_OPEN},
+    {MEASURE_INDUCTANCE, SIM_DUT_INDUCTOR, 10e-3, 50, "L 10 mH 50 Ohm", RESULT_OVER_RANGE}
+};
+#define FAULT_COUNT (sizeof(faults) / sizeof(faults[0]))
+
+const char* typeNames[] = {"none", "R", "C", "L", "auto"};
+const char* statusNames[] = {"ok", "open", "short", "over-range"};
+
+MEASUREMENT_TYPE getMeasurementType(SIM_DUT_TYPE type)
+{
+    switch(type)
+    {
+        case SIM_DUT_RESISTOR:
+            return MEASURE_RESISTANCE;
+        case SIM_DUT_CAPACITOR:
+            return MEASURE_CAPACITANCE;
+        case SIM_DUT_INDUCTOR:
+            return MEASURE_INDUCTANCE;
+        default:
+            return MEASURE_NONE;
+    }
+}
+
+// Value of a result in Ohm, F or H
+double getBaseValue(MEASUREMENT_RESULT* result)
+{
+    return (result->type == MEASURE_RESISTANCE) ? result->value : result->value * 1e-6;
+}
+
+// Runs the main loop until a result comes out, returns false on a timeout
+bool takeReading(MEASUREMENT_TYPE type, MEASUREMENT_RESULT* result)
+{
+    uint64_t start = simGetCycles();
+    requestMeasurement(type);
+    while(!getMeasurementResult(result))
+    {
+        stepMeasurement();
+        simAdvance(MAIN_LOOP_CYCLES);
+        if(simGetCycles() - start > READING_TIMEOUT)
+            return false;
+    }
+    while(!isMeasurementIdle())
+    {
+        stepMeasurement();
+        simAdvance(MAIN_LOOP_CYCLES);
+    }
+    return true;
+}
+
+// Zeroes a type the way the zero command does, the readings never reach the history
+void benchZero(MEASUREMENT_TYPE type)
+{
+    MEASUREMENT_RESULT result;
+
+    startZero(type);
+    do
+    {
+        while(!takeMeasurementResult(&result))
+        {
+            stepMeasurement();
+            simAdvance(MAIN_LOOP_CYCLES);
+        }
+    }
+    while(addZeroReading(&result));
+    while(!isMeasurementIdle())
+    {
+        stepMeasurement();
+        simAdvance(MAIN_LOOP_CYCLES);
+    }
+}
+
+void benchPart(const BENCH_PART* part, uint32_t readings, bool isAuto)
+{
+    MEASUREMENT_TYPE type = isAuto ? MEASURE_AUTO : getMeasurementType(part->type);
+    MEASUREMENT_RESULT result;
+    double sum = 0, low = INFINITY, high = -INFINITY;
+    uint64_t start, first = 0;
+    uint32_t i, wrongType = 0;
+
+    simSetDut(part->type, part->value, part->esr);
+    start = simGetCycles();
+    for(i = 0; i < readings; i++)
+    {
+        if(!takeReading(type, &result))
+        {
+            // There is no way to abort a measurement, so nothing after this can be trusted
+            printf("%-16s timed out\n", part->name);
+            exit(1);
+        }
+        if(i == 0)
+            first = simGetCycles() - start;
+        if(result.status != RESULT_OK)
+        {
+            printf("%-16s %s\n", part->name, statusNames[result.status]);
+            return;
+        }
+        if(result.type != getMeasurementType(part->type))
+        {
+            wrongType++;
+            continue;
+        }
+        double value = getBaseValue(&result);
+        sum += value;
+        if(value < low)
+            low = value;
+        if(value > high)
+            high = value;
+    }
+
+    double total = (double)(simGetCycles() - start) / SIM_CLOCK_HZ;
+    double rest = total - (double)first / SIM_CLOCK_HZ;
+    uint32_t good = readings - wrongType;
+    double mean = good ? sum / good : 0;
+
+    printf("%-16s %12.6g %+9.3f%% %8.3f%% %11.3f %12.2f",
+           part->name, mean, good ? 100 * (mean - part->value) / part->value : 0,
+           good ? 100 * (high - low) / part->value : 0, (1000.0 * first) / SIM_CLOCK_HZ,
+           (readings > 1 && rest > 0) ? (readings - 1) / rest : 1 / total);
+    if(isAuto)
+        printf("   %s %u/%u", typeNames[result.type], good, readings);
+    printf("\n");
+}
+
+// Reads a small part once, the reading is ok if it is within SMALL_PART_COUNTS counts of the part
+void benchSmallPart(const BENCH_PART* part)
+{
+    MEASUREMENT_TYPE type = getMeasurementType(part->type);
+    MEASUREMENT_RESULT result;
+    // One count in Ohm or F
+    double count = (type == MEASURE_RESISTANCE) ? 1 / RESISTANCE_CONST : 1e-6 / CAPACITANCE_CONST;
+
+    simSetDut(part->type, part->value, part->esr);
+    if(!takeReading(type, &result))
+    {
+        printf("%-16s timed out\n", part->name);
+        exit(1);
+    }
+    if(result.status != RESULT_OK)
+    {
+        printf("%-16s %12s %10s %12s\n", part->name, statusNames[result.status], "", "WRONG");
+        return;
+    }
+    double value = getBaseValue(&result);
+    printf("%-16s %12.6g %+9.3f%% %12s\n", part->name, value, 100 * (value - part->value) / part->value,
+           fabs(value - part->value) <= SMALL_PART_COUNTS * count ? "ok" : "WRONG");
+}
+
+// Checks that a fixture with nothing measurable in it is reported, and how long that takes
+void benchFault(const BENCH_FAULT* fault)
+{
+    MEASUREMENT_RESULT result;
+    uint64_t start;
+
+    simSetDut(fault->dut, fault->value, fault->esr);
+    start = simGetCycles();
+    if(!takeReading(fault->type, &result))
+    {
+        printf("%-16s timed out\n", fault->name);
+        exit(1);
+    }
+    printf("%-16s %12s %12s %11.3f\n", fault->name, statusNames[result.status],
+           result.status == fault->expected ? "ok" : "WRONG", (1000.0 * (simGetCycles() - start)) / SIM_CLOCK_HZ);
+}
+
+// Set by the stream once its summary is queued
+bool isStreamDone = false;
+
+// The tasks of main.c the stream runs with, the firmware's own are not part of the bench
+void benchMeasurementTask()
+{
+    bool isPending = isMeasurementRequestPending();
+    stepMeasurement();
+    if(isPending && !isMeasurementRequestPending())
+        postEvent(EVENT_STREAM);
+    if(isMeasurementStepDue())
+        postEvent(EVENT_MEASURE);
+}
+
+void benchReportTask()
+{
+    MEASUREMENT_RESULT result;
+    while(sendResultLine() && getMeasurementResult(&result))
+        printMeasurementResult(&result);
+}
+
+void benchUartTask()
+{
+    serviceUart0();
+    if(isStreaming() && kbhitUart0())
+    {
+        getcUart0();
+        stopStream();
+    }
+}
+
+void benchCommandDoneTask()
+{
+    isStreamDone = true;
+}
+
+// Streams a part for the given time and reports the summary line the firmware sends at the end
+void benchStream(const BENCH_PART* part, double seconds, bool isAuto)
+{
+    MEASUREMENT_TYPE type = isAuto ? MEASURE_AUTO : getMeasurementType(part->type);
+    MEASUREMENT_RESULT result;
+    uint64_t start;
+
+    // A part that needs more than a tenth of the time for one reading says nothing about the stream,
+    // and the stream's main loop is slow to simulate
+    simSetDut(part->type, part->value, part->esr);
+    start = simGetCycles();
+    if(!takeReading(type, &result))
+    {
+        printf("%-16s timed out\n", part->name);
+        exit(1);
+    }
+    if(simGetCycles() - start > seconds * SIM_CLOCK_HZ / 10)
+    {
+        printf("%-16s skipped, %.1f ms a reading\n", part->name, (1000.0 * (simGetCycles() - start)) / SIM_CLOCK_HZ);
+        return;
+    }
+
+    simReceiveUartAt(simGetCycles() + (uint64_t)(seconds * SIM_CLOCK_HZ), " ");
+    isStreamDone = false;
+    startStream(type, 0);
+    while(!isStreamDone)
+    {
+        runReadyTasks();
+        simAdvance(MAIN_LOOP_CYCLES);
+    }
+    // The summary is still in the transmit queue, uart0Isr() sends it
+    while(!isUart0QueueEmpty())
+        simAdvance(1000);
+    // The last character is only seen by the simulator on the next register access
+    simAdvance(1);
+    printf("%-16s %s\n", part->name, simGetUartLine());
+}
+
+// Reads a part with the temperature compensation off and on, the difference is what its coefficient takes out
+void benchTempco(const BENCH_PART* part)
+{
+    MEASUREMENT_TYPE type = getMeasurementType(part->type);
+    MEASUREMENT_RESULT raw, compensated;
+
+    simSetDut(part->type, part->value, part->esr);
+    setTemperatureCompensation(false);
+    bool isRead = takeReading(type, &raw);
+    setTemperatureCompensation(true);
+    if(!isRead || !takeReading(type, &compensated))
+    {
+        printf("%-16s timed out\n", part->name);
+        exit(1);
+    }
+    printf("%-16s %+6d ppm/C %12.6g %12.6g %+9.3f%%\n", part->name, getTemperatureCoefficient(type),
+           getBaseValue(&raw), getBaseValue(&compensated),
+           100 * (getBaseValue(&compensated) - getBaseValue(&raw)) / getBaseValue(&raw));
+}
+
+// Same table as the prof command, in simulated cycles
+void printBenchProfile()
+{
+#ifdef PROFILE
+    PROBE_STATS stats;
+    uint8_t probe;
+
+    printf("\n%-12s %8s %10s %10s %10s\n", "probe", "n", "min", "avg", "max");
+    for(probe = 0; probe < PROBE_COUNT; probe++)
+    {
+        getProbeStats((PROFILE_PROBE)probe, &stats);
+        printf("%-12s %8u %10u %10llu %10u\n", getProbeName((PROFILE_PROBE)probe), stats.count, stats.min,
+               (unsigned long long)(stats.count ? stats.total / stats.count : 0), stats.max);
+    }
+#endif
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t readings = 5;
+    bool isAuto = false;
+    bool isFaults = false;
+    bool isZero = false;
+    bool isFixture = false;
+    bool isTempco = false;
+    double streamSeconds = 0;
+    uint32_t baudRate = 115200;
+    uint8_t i;
+
+    simInit();
+    simSetUartEcho(false);
+
+    initLcrMeter();
+    initTimer();
+    initComparator0();
+    initComparator1();
+    initAdc0Ss3();
+    initChargeFit();
+    setAdc0Ss3Mux(3);
+    setAdc0Ss3Log2AverageCount(2);
+    initEsrSequence();
+#ifdef PROFILE
+    initProfiler();
+#endif
+
+    for(i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-hw") == 0)
+            setCaptureMode(CAPTURE_HARDWARE);
+        else if(strcmp(argv[i], "-fixed") == 0)
+            setDischargeMode(DISCHARGE_FIXED, getDischargeThreshold());
+        else if(strcmp(argv[i], "-fit") == 0)
+            setCapacitanceFit(true);
+        else if(strcmp(argv[i], "-auto") == 0)
+            isAuto = true;
+        else if(strcmp(argv[i], "-dual") == 0)
+            setThresholdMode(THRESHOLD_DUAL);
+        else if(strcmp(argv[i], "-faults") == 0)
+            isFaults = true;
+        else if(strcmp(argv[i], "-zero") == 0)
+            isZero = true;
+        else if(strcmp(argv[i], "-fixture") == 0)
+        {
+            isFixture = true;
+            simSetFixture(FIXTURE_LEAD_OHMS, FIXTURE_STRAY_F);
+        }
+        else if(strcmp(argv[i], "-temp") == 0 && i + 1 < argc)
+            simSetTemperature(atof(argv[++i]));
+        else if(strcmp(argv[i], "-tempco") == 0)
+        {
+            isTempco = true;
+            setTemperatureCoefficient(MEASURE_RESISTANCE, SIM_BOARD_TEMPCO_PPM);
+            setTemperatureCoefficient(MEASURE_CAPACITANCE, SIM_BOARD_TEMPCO_PPM);
+            setTemperatureCoefficient(MEASURE_INDUCTANCE, SIM_BOARD_TEMPCO_PPM);
+        }
+        else if(strcmp(argv[i], "-stream") == 0 && i + 1 < argc)
+            streamSeconds = atof(argv[++i]);
+        else if(strcmp(argv[i], "-baud") == 0 && i + 1 < argc)
+            baudRate = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            readings = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-noise") == 0 && i + 1 < argc)
+            simSetNoise(atof(argv[++i]));
+        else
+        {
+            printf("usage: %s [-hw] [-fixed] [-fit] [-auto] [-dual] [-faults] [-fixture] [-zero] [-temp celsius] [-tempco] [-stream seconds] [-baud rate] [-n readings] [-noise lsb]\n", argv[0]);
+            return 1;
+        }
+    }
+    if(readings < 1)
+        readings = 1;
+    if(readings > MAX_READINGS)
+        readings = MAX_READINGS;
+
+    printf("capture %s, threshold %s, discharge %s, capacitance fit %s, %u readings per part\n\n",
+           getCaptureMode() == CAPTURE_HARDWARE ? "hardware" : "software",
+           getThresholdMode() == THRESHOLD_DUAL ? "dual" : "single",
+           getDischargeMode() == DISCHARGE_ADAPTIVE ? "adaptive" : "fixed",
+           getCapacitanceFit() ? "on" : "off", readings);
+    if(isZero)
+    {
+        // Without -fixture a simulated fixture has no leads, what is left is the latency of the capture
+        simSetDut(SIM_DUT_OPEN, 0, 0);
+        benchZero(MEASURE_CAPACITANCE);
+        simSetDut(SIM_DUT_RESISTOR, 1e-3, 0);
+        benchZero(MEASURE_RESISTANCE);
+        benchZero(MEASURE_INDUCTANCE);
+        printf("zero offsets: R %u, C %u, L %u counts\n\n", getZeroOffset(MEASURE_RESISTANCE),
+               getZeroOffset(MEASURE_CAPACITANCE), getZeroOffset(MEASURE_INDUCTANCE));
+    }
+    if(isFaults)
+    {
+        printf("%-16s %12s %12s %11s\n", "fixture", "status", "expected", "time (ms)");
+        for(i = 0; i < FAULT_COUNT; i++)
+            benchFault(&faults[i]);
+        return 0;
+    }
+    if(streamSeconds > 0)
+    {
+        // Only the stream needs the UART and the millisecond count, the other benches print nothing
+        initUart0();
+        if(!setUart0BaudRate(baudRate, SYSTEM_CLOCK_HZ))
+        {
+            printf("%u baud can't be made from a %u Hz clock\n", baudRate, SYSTEM_CLOCK_HZ);
+            return 1;
+        }
+        printf("%u baud, error %d ppm%s\n\n", getUart0BaudRate(), getUart0BaudError(), isUart0HighSpeed() ? ", high speed" : "");
+        enableUart0Interrupts();
+        initSystickTimer();
+        addTask(benchMeasurementTask, EVENT_MASK(EVENT_MEASURE));
+        addTimedTask(benchReportTask, 1, EVENT_MASK(EVENT_RESULT));
+        addTask(benchCommandDoneTask, EVENT_MASK(EVENT_COMMAND_DONE));
+        addTimedTask(benchUartTask, 1, 0);
+        addTimedTask(streamTask, 1, EVENT_MASK(EVENT_STREAM));
+        for(i = 0; i < PART_COUNT; i++)
+            benchStream(&parts[i], streamSeconds, isAuto);
+        printBenchProfile();
+        return 0;
+    }
+
+    printf("%-16s %12s %10s %9s %11s %12s\n", "part", "mean", "error", "spread", "first (ms)", "readings/s");
+
+    for(i = 0; i < PART_COUNT; i++)
+        benchPart(&parts[i], readings, isAuto);
+    if(isAuto)
+    {
+        for(i = 0; i < LARGE_PART_COUNT; i++)
+            benchPart(&largeParts[i], 1, isAuto);
+    }
+
+    if(isFixture || isZero)
+    {
+        printf("\n%-16s %12s %10s %12s\n", "part", "reading", "error", "2 counts");
+        for(i = 0; i < SMALL_PART_COUNT; i++)
+            benchSmallPart(&smallParts[i]);
+    }
+
+    printf("\nboard temperature read as %.1f C\n", getTemperature());
+    if(isTempco)
+    {
+        // One part of each type, the compensation has to move it unless the board is at CALIBRATION_TEMP_C
+        printf("\n%-16s %12s %12s %12s %10s\n", "part", "tempco", "raw", "compensated", "shift");
+        benchTempco(&parts[1]);
+        benchTempco(&parts[7]);
+        benchTempco(&parts[11]);
+    }
+    if(getDroppedCaptures() > 0)
+        printf("\n%u captures dropped\n", getDroppedCaptures());
+    printBenchProfile();
+    return 0;
+}
@@ -0,0 +1,162 @@
+// Simulator Register Redirection
+// Sarker Nadir Afridi Azmi
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: Linux PC, host builds only
+// Simulated uC:    TM4C123GH6PM
+// System Clock:    40 MHz (simulated)
+
+// Force included ahead of every file of a host build (gcc -include host/sim_registers.h)
+// Every peripheral register is ordinary memory mapped at its real address by simInit()
+// The registers below have side effects (running counts, FIFOs, write 1 to clear flags),
+// so they go through simRegister(), which advances the simulation before the access
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef SIM_REGISTERS_H_
+#define SIM_REGISTERS_H_
+
+#include <stdint.h>
+#include "../tm4c123gh6pm.h"
+#include "sim.h"
+
+#define SIM_REGISTER(address)   (*simRegister(address))
+
+// TI compiler intrinsic
+#define _delay_cycles(n)        simAdvance(n)
+
+// General purpose timers
+#undef TIMER1_CTL_R
+#undef TIMER1_RIS_R
+#undef TIMER1_ICR_R
+#undef TIMER1_TAILR_R
+#undef TIMER1_TAR_R
+#undef TIMER1_TAV_R
+#define TIMER1_CTL_R            SIM_REGISTER(0x4003100C)
+#define TIMER1_RIS_R            SIM_REGISTER(0x4003101C)
+#define TIMER1_ICR_R            SIM_REGISTER(0x40031024)
+#define TIMER1_TAILR_R          SIM_REGISTER(0x40031028)
+#define TIMER1_TAR_R            SIM_REGISTER(0x40031048)
+#define TIMER1_TAV_R            SIM_REGISTER(0x40031050)
+
+#undef TIMER2_CTL_R
+#undef TIMER2_RIS_R
+#undef TIMER2_ICR_R
+#undef TIMER2_TAILR_R
+#undef TIMER2_TAR_R
+#undef TIMER2_TAV_R
+#define TIMER2_CTL_R            SIM_REGISTER(0x4003200C)
+#define TIMER2_RIS_R            SIM_REGISTER(0x4003201C)
+#define TIMER2_ICR_R            SIM_REGISTER(0x40032024)
+#define TIMER2_TAILR_R          SIM_REGISTER(0x40032028)
+#define TIMER2_TAR_R            SIM_REGISTER(0x40032048)
+#define TIMER2_TAV_R            SIM_REGISTER(0x40032050)
+
+#undef WTIMER0_CTL_R
+#undef WTIMER0_RIS_R
+#undef WTIMER0_ICR_R
+#undef WTIMER0_TAILR_R
+#undef WTIMER0_TAR_R
+#undef WTIMER0_TAV_R
+#define WTIMER0_CTL_R           SIM_REGISTER(0x4003600C)
+#define WTIMER0_RIS_R           SIM_REGISTER(0x4003601C)
+#define WTIMER0_ICR_R           SIM_REGISTER(0x40036024)
+#define WTIMER0_TAILR_R         SIM_REGISTER(0x40036028)
+#define WTIMER0_TAR_R           SIM_REGISTER(0x40036048)
+#define WTIMER0_TAV_R           SIM_REGISTER(0x40036050)
+#undef WTIMER0_TBV_R
+#define WTIMER0_TBV_R           SIM_REGISTER(0x40036054)
+
+#undef WTIMER1_CTL_R
+#undef WTIMER1_RIS_R
+#undef WTIMER1_ICR_R
+#undef WTIMER1_TAILR_R
+#undef WTIMER1_TAR_R
+#undef WTIMER1_TAV_R
+#define WTIMER1_CTL_R           SIM_REGISTER(0x4003700C)
+#define WTIMER1_RIS_R           SIM_REGISTER(0x4003701C)
+#define WTIMER1_ICR_R           SIM_REGISTER(0x40037024)
+#define WTIMER1_TAILR_R         SIM_REGISTER(0x40037028)
+#define WTIMER1_TAR_R           SIM_REGISTER(0x40037048)
+#define WTIMER1_TAV_R           SIM_REGISTER(0x40037050)
+#undef WTIMER1_TAPS_R
+#define WTIMER1_TAPS_R          SIM_REGISTER(0x4003705C)
+
+// ADC0 and ADC1
+#undef ADC0_ACTSS_R
+#undef ADC0_RIS_R
+#undef ADC0_ISC_R
+#undef ADC0_PSSI_R
+#undef ADC0_SSFIFO1_R
+#undef ADC0_SSFSTAT1_R
+#undef ADC0_SSFIFO3_R
+#undef ADC0_SSFSTAT3_R
+#define ADC0_ACTSS_R            SIM_REGISTER(0x40038000)
+#define ADC0_RIS_R              SIM_REGISTER(0x40038004)
+#define ADC0_ISC_R              SIM_REGISTER(0x4003800C)
+#define ADC0_PSSI_R             SIM_REGISTER(0x40038028)
+#define ADC0_SSFIFO1_R          SIM_REGISTER(0x40038068)
+#define ADC0_SSFSTAT1_R         SIM_REGISTER(0x4003806C)
+#define ADC0_SSFIFO3_R          SIM_REGISTER(0x400380A8)
+#define ADC0_SSFSTAT3_R         SIM_REGISTER(0x400380AC)
+
+#undef ADC1_ACTSS_R
+#undef ADC1_RIS_R
+#undef ADC1_ISC_R
+#undef ADC1_PSSI_R
+#undef ADC1_SSFIFO3_R
+#undef ADC1_SSFSTAT3_R
+#define ADC1_ACTSS_R            SIM_REGISTER(0x40039000)
+#define ADC1_RIS_R              SIM_REGISTER(0x40039004)
+#define ADC1_ISC_R              SIM_REGISTER(0x4003900C)
+#define ADC1_PSSI_R             SIM_REGISTER(0x40039028)
+#define ADC1_SSFIFO3_R          SIM_REGISTER(0x400390A8)
+#define ADC1_SSFSTAT3_R         SIM_REGISTER(0x400390AC)
+
+// Analog comparators
+#undef COMP_ACMIS_R
+#undef COMP_ACRIS_R
+#undef COMP_ACSTAT0_R
+#define COMP_ACMIS_R            SIM_REGISTER(0x4003C000)
+#define COMP_ACRIS_R            SIM_REGISTER(0x4003C004)
+#define COMP_ACSTAT0_R          SIM_REGISTER(0x4003C020)
+#undef COMP_ACSTAT1_R
+#define COMP_ACSTAT1_R          SIM_REGISTER(0x4003C040)
+
+// UART0
+#undef UART0_DR_R
+#undef UART0_FR_R
+#define UART0_DR_R              SIM_REGISTER(0x4000C000)
+#define UART0_FR_R              SIM_REGISTER(0x4000C018)
+#undef UART0_ICR_R
+#define UART0_ICR_R             SIM_REGISTER(0x4000C044)
+
+// uDMA
+#undef UDMA_ENASET_R
+#undef UDMA_ENACLR_R
+#undef UDMA_CHIS_R
+#define UDMA_ENASET_R           SIM_REGISTER(0x400FF028)
+#define UDMA_ENACLR_R           SIM_REGISTER(0x400FF02C)
+#define UDMA_CHIS_R             SIM_REGISTER(0x400FF504)
+
+// Software trigger of the NVIC
+#undef NVIC_SW_TRIG_R
+#define NVIC_SW_TRIG_R          SIM_REGISTER(0xE000EF00)
+
+// SysTick
+#undef NVIC_ST_CTRL_R
+#undef NVIC_ST_RELOAD_R
+#undef NVIC_ST_CURRENT_R
+#define NVIC_ST_CTRL_R          SIM_REGISTER(0xE000E010)
+#define NVIC_ST_RELOAD_R        SIM_REGISTER(0xE000E014)
+#define NVIC_ST_CURRENT_R       SIM_REGISTER(0xE000E018)
+
+// DWT cycle counter, for profile.c
+#define DWT_CYCCNT_R            SIM_REGISTER(0xE0001004)
+
+#endif
@@ -11,369 +11,697 @@
 #include "uart0.h"
 #include "common_terminal_interface.h"
 #include "adc0.h"
+#include "measure.h"
+#include "fit.h"
+#include "format.h"
+#include "sort.h"
+#include "stream.h"
+#include "history.h"
+#include "profile.h"
+#include "scheduler.h"
 #include <stdio.h>
 
-#define INTEGRATE               PORTA,6
-#define MEAS_LR                 PORTA,7
-#define LOWSIDE_R               PORTB,5
-#define HIGHSIDE_R              PORTB,6
-#define MEAS_C                  PORTB,7
-
-#define ANALOG_COMPARATOR0      PORTC,7
-
-#define DISCHARGE_TIME          1000000
-#define RESISTANCE_CONST        57.90883367
-#define CAPACITANCE_CONST       5194551.85
-#define INDUCTANCE_CONST        1.5303
-#define VSUPPLY                 3.295
-#define R33OHMS                 32.7
-
-// PortE masks
-#define AIN3                    PORTE,0
-#define AIN2                    PORTE,1
-#define AIN1                    PORTE,2
-
-#define ABS(N) (((N)<0)?(-N):(N))
-
-// Get the count after compare value in C0 is reached
-float chargeTime = 0;
-bool isResistanceMeasurement = false;
-bool isCapacitanceMeasurement = false;
-bool isInductanceMeasurement = false;
-float startingVoltage = 0;
-float endingVoltage = 0;
 char str[100];
 
-void initLcrMeter()
-{
-    initSystemClockTo40Mhz();
-
-    enablePort(PORTA);
-    enablePort(PORTB);
-    enablePort(PORTE);
-
-    selectPinPushPullOutput(MEAS_LR);
-    selectPinPushPullOutput(INTEGRATE);
-    selectPinPushPullOutput(LOWSIDE_R);
-    selectPinPushPullOutput(HIGHSIDE_R);
-    selectPinPushPullOutput(MEAS_C);
+USER_DATA data;
+// Set from the line coming in until the command is done with it
+bool isLineReady = false;
 
-    selectPinAnalogInput(AIN3);
-    selectPinAnalogInput(AIN2);
-    selectPinAnalogInput(AIN1);
+// Where terminalTask() is with the line
+// A command that drives the analog front end WAITS until the engine is idle, then runs from the same parsed line
+// ZEROING takes the readings of the zero command, reportTask() leaves them alone
+typedef enum _COMMAND_STATE
+{
+    COMMAND_NONE,
+    COMMAND_NEW,
+    COMMAND_WAITING,
+    COMMAND_ZEROING
+} COMMAND_STATE;
+
+COMMAND_STATE commandState = COMMAND_NONE;
+MEASUREMENT_TYPE zeroingType = MEASURE_NONE;
+
+// Phases of a sort, stepped by sortTask()
+// STARTING waits for the engine to be idle, MEASURING for the result of the part that was strobed in
+typedef enum _SORT_STATE
+{
+    SORT_OFF,
+    SORT_STARTING,
+    SORT_WAITING,
+    SORT_MEASURING
+} SORT_STATE;
+
+SORT_STATE sortState = SORT_OFF;
+bool isSortStopped = false;
+uint32_t sortStart = 0;
+uint32_t sortedParts = 0;
+
+void checkMeasurementQueued(bool isQueued)
+{
+    if(!isQueued)
+        putsUart0("Measurement queue full\n");
 }
 
-void resetMeasurements()
+// Min, max, mean and standard deviation of every type in the history
+void printHistoryStats()
 {
-    setPinValue(MEAS_LR, 0);
-    setPinValue(MEAS_C, 0);
-    setPinValue(INTEGRATE, 0);
-    setPinValue(LOWSIDE_R, 0);
-    setPinValue(HIGHSIDE_R, 0);
+    const char* names[] = {"", "Resistance", "Capacitance", "Inductance"};
+    const char* units[] = {"", "Ohm", "F", "H"};
+    // The engine works in uF and uH
+    const float scales[] = {0, 1, 1e-6f, 1e-6f};
+    HISTORY_STATS stats;
+    bool isEmpty = true;
+    uint8_t type;
+    char* end;
+
+    for(type = MEASURE_RESISTANCE; type <= MEASURE_INDUCTANCE; type++)
+    {
+        if(!getHistoryStats((MEASUREMENT_TYPE)type, &stats))
+            continue;
+        isEmpty = false;
+        end = formatString(str, names[type]);
+        end = formatString(end, ": n = ");
+        end = formatUnsigned(end, stats.count);
+        end = formatString(end, ", min = ");
+        end = formatEngineering(end, stats.min * scales[type], units[type]);
+        end = formatString(end, ", max = ");
+        end = formatEngineering(end, stats.max * scales[type], units[type]);
+        end = formatString(end, ", mean = ");
+        end = formatEngineering(end, stats.mean * scales[type], units[type]);
+        end = formatString(end, ", stddev = ");
+        end = formatEngineering(end, stats.stddev * scales[type], units[type]);
+        formatString(end, "\n");
+        putsUart0(str);
+    }
+    if(isEmpty)
+        putsUart0("No readings in the history\n");
 }
 
-void initTimer()
+// Cycles spent in every probe, needs a build with PROFILE defined
+void printProfile()
 {
-    SYSCTL_RCGCTIMER_R |= SYSCTL_RCGCTIMER_R0;
-    _delay_cycles(3);
+#ifdef PROFILE
+    PROBE_STATS stats;
+    uint8_t probe;
 
-    TIMER0_CTL_R &= ~TIMER_CTL_TAEN;                 // turn-off timer before reconfiguring
-    TIMER0_CFG_R = TIMER_CFG_32_BIT_TIMER;           // configure as 32-bit timer (A+B)
-    TIMER0_TAMR_R |= TIMER_TAMR_TAMR_1_SHOT | TIMER_TAMR_TACDIR;
+    putsUart0("Probe          n          min        avg        max (cycles)\n");
+    for(probe = 0; probe < PROBE_COUNT; probe++)
+    {
+        getProbeStats((PROFILE_PROBE)probe, &stats);
+        sprintf(str, "%-12s %8lu %10lu %10lu %10lu\n", getProbeName((PROFILE_PROBE)probe), (unsigned long)stats.count,
+                (unsigned long)stats.min, (unsigned long)(stats.count ? stats.total / stats.count : 0), (unsigned long)stats.max);
+        putsUart0(str);
+    }
+#else
+    putsUart0("Profiler not built in, define PROFILE\n");
+#endif
 }
 
-void initComparator0()
+void printSortCounts()
 {
-    // Provide a clock to the Analog Comparator module
-    SYSCTL_RCGCACMP_R |= SYSCTL_RCGCACMP_R0;
-    _delay_cycles(3);
-
-    enablePort(PORTC);
-    selectPinAnalogInput(ANALOG_COMPARATOR0);
-
-    /*
-     * Use the internal reference voltage
-     * VIN- > VIN+, VOUT = 0; We want to invert the output so that the interrupt is triggered when the output is 1
-     * Trigger interrupt on rising edge and when comparator output is high
-     */
-    COMP_ACCTL0_R |= COMP_ACCTL0_ASRCP_REF | COMP_ACCTL0_ISEN_RISE | COMP_ACCTL0_CINV;
-    // Enable resistor ladder and use a reference voltage of 2.469V
-    COMP_ACREFCTL_R |= COMP_ACREFCTL_EN | COMP_ACREFCTL_VREF_M;
-    waitMicrosecond(10);
-    // Turn off interrupts
-    COMP_ACINTEN_R &= ~COMP_ACINTEN_IN0;
-    // Vector Number = 41, Interrupt Number = 25
-    NVIC_EN0_R |= 1 << (INT_COMP0-16);
+    SORT_COUNTS counts;
+    uint8_t tolerances[SORT_MAX_BANDS];
+    uint8_t bands = getSortBands(tolerances);
+    uint8_t i;
+    char* end;
+
+    if(bands == 0)
+    {
+        putsUart0("No bins set\n");
+        return;
+    }
+
+    getSortCounts(&counts);
+    end = formatString(str, "Nominal = ");
+    if(getSortType() == MEASURE_CAPACITANCE)
+        end = formatEngineering(end, getSortNominal() * 1e-6f, "F");
+    else
+        end = formatEngineering(end, getSortNominal(), "Ohm");
+    end = formatString(end, ", parts = ");
+    end = formatUnsigned(end, counts.total);
+    formatString(end, "\n");
+    putsUart0(str);
+
+    for(i = 0; i < bands; i++)
+    {
+        end = formatString(str, "Bin ");
+        end = formatUnsigned(end, i + 1);
+        end = formatString(end, " (+/-");
+        end = formatUnsigned(end, tolerances[i]);
+        end = formatString(end, "%) = ");
+        end = formatUnsigned(end, counts.bins[i]);
+        formatString(end, "\n");
+        putsUart0(str);
+    }
+    end = formatString(str, "Fail = ");
+    end = formatUnsigned(end, counts.fail);
+    formatString(end, "\n");
+    putsUart0(str);
 }
 
-float getDut2Voltage()
+// Measures a part every time one is strobed in on PART_PRESENT from sortTask(), until stopSort()
+void startSort()
 {
-    // Read the conversion result of DUT2
-    setAdc0Ss3Mux(3);
-    uint16_t Rdut2 = readAdc0Ss3();
-    float dut2 = (VSUPPLY * (Rdut2 + 0.5)) / 4096.0;
-    return dut2;
+    isSortStopped = false;
+    sortState = SORT_STARTING;
+    postEvent(EVENT_SORT);
 }
 
-/*
- * This function returns the resistance of the device under test
- * This only works for small values of R where R < 100 Ohm's
- */
-float readDutResistance()
+// A part that is being measured is still sorted before the sort stops
+void stopSort()
 {
-    // Read the collector conversion result of Q3 (NPN Transistor)
-    setAdc0Ss3Mux(1);
-    uint16_t RQ3Vc = readAdc0Ss3();
-    // Read the collector conversion result of Q7 (PNP Transistor)
-    setAdc0Ss3Mux(2);
-    uint16_t RQ7Vc = readAdc0Ss3();
-    // Read the conversion result of DUT2
-    setAdc0Ss3Mux(3);
-    uint16_t Rdut2 = readAdc0Ss3();
-    /*
-     * Use the voltage divider rule to find small values of R
-     * R1 / R2 = V1 / V2
-     * V1 = Q7Vc - DUT2
-     * V2 = DUT2 - Q3Vc
-     * R2 = 32.7 Ohm's
-     */
-    float q3Vc = (VSUPPLY * (RQ3Vc + 0.5)) / 4096.0;
-    float q7Vc = (VSUPPLY * (RQ7Vc + 0.5)) / 4096.0;
-    float dut2 = (VSUPPLY * (Rdut2 + 0.5)) / 4096.0;
-    float dut2ResistancePd = q7Vc - dut2;
-    // Reuse dut2ResistancePd to save stack space
-    // This is the esr we are trying to calculate
-    dut2ResistancePd = (dut2ResistancePd / (dut2 - q3Vc)) * R33OHMS;
-    return dut2ResistancePd;
+    isSortStopped = true;
+    postEvent(EVENT_SORT);
 }
 
-float measureEsr()
+// Called by reportTask() with the result of the part that was strobed in
+void sortPart(MEASUREMENT_RESULT* result)
 {
-    float esr = 0.00;
-    // Measure the esr
-    setPinValue(MEAS_LR, 1);
-    setPinValue(LOWSIDE_R, 1);
-    waitMicrosecond(1000);
-    esr = readDutResistance();
-    setPinValue(MEAS_LR, 0);
-    setPinValue(LOWSIDE_R, 0);
-    return esr;
+    sortResult(result);
+    // Contact bounce while the part was being measured is not a new part
+    clearPartPresent();
+    sortedParts++;
+    sortState = SORT_WAITING;
+    postEvent(EVENT_SORT);
 }
 
-// Records the timer value after the comparator reaches 2.467V
-void comparator0Isr()
+// Runs every ms and on EVENT_SORT, the strobe is latched so polling it on the tick is enough
+// Nothing is printed per part, posts EVENT_COMMAND_DONE once the counts are out
+void sortTask()
 {
-    chargeTime = TIMER0_TAV_R;
-    // Clear the interrupt flag
-    COMP_ACMIS_R |= COMP_ACMIS_IN0;
-    TIMER0_CTL_R &= ~TIMER_CTL_TAEN;
+    uint32_t elapsed;
+    char* end;
 
-    if(isResistanceMeasurement)
+    switch(sortState)
     {
-        isResistanceMeasurement = false;
-        setPinValue(MEAS_LR, 0);
-        // Discharge the 1uF capacitor
-        setPinValue(INTEGRATE, 1);
-        setPinValue(LOWSIDE_R, 1);
-        chargeTime /= RESISTANCE_CONST;
-        sprintf(str, "Resistance = %.2f Ohm's\n", chargeTime);
-        putsUart0(str);
+        case SORT_OFF:
+        case SORT_MEASURING:
+            break;
+        case SORT_STARTING:
+            // Whatever was asked for before the sort is printed, not sorted, and is out before the sort starts
+            if(!isMeasurementIdle() || !sendResultLine() || !isUart0QueueEmpty())
+                break;
+            clearSortOutputs();
+            clearPartPresent();
+            putsUart0("Sorting, press any key to stop\n");
+            sortStart = getMilliseconds();
+            sortedParts = 0;
+            sortState = SORT_WAITING;
+            // fall through
+        case SORT_WAITING:
+            if(!isSortStopped)
+            {
+                if(isPartPresent())
+                {
+                    clearSortOutputs();
+                    clearPartPresent();
+                    requestMeasurement(getSortType());
+                    sortState = SORT_MEASURING;
+                }
+            }
+            // The counts are only printed into an empty transmit queue, so all of them fit
+            else if(isUart0QueueEmpty())
+            {
+                elapsed = getMilliseconds() - sortStart;
+                end = formatUnsigned(str, sortedParts);
+                end = formatString(end, " parts in ");
+                end = formatUnsigned(end, elapsed);
+                end = formatString(end, " ms, ");
+                end = formatFixed(end, elapsed ? ((uint64_t)sortedParts * 100000) / elapsed : 0, 2);
+                formatString(end, " parts/sec\n");
+                putsUart0(str);
+                printSortCounts();
+                sortState = SORT_OFF;
+                postEvent(EVENT_COMMAND_DONE);
+            }
+            break;
     }
+}
 
-    if(isCapacitanceMeasurement)
+// Runs on EVENT_MEASURE, from a request, the phase timer, a capture or the fit and burst sampling
+// It only runs again on the next pass when a step is due at once, otherwise the core sleeps until then
+// A request the engine has just taken lets streamTask() queue the next one
+void measurementTask()
+{
+    bool isPending = isMeasurementRequestPending();
+    stepMeasurement();
+    if(isPending && !isMeasurementRequestPending())
+        postEvent(EVENT_STREAM);
+    if(isMeasurementStepDue())
+        postEvent(EVENT_MEASURE);
+}
+
+// Runs every ms and on EVENT_RESULT, a line that doesn't fit in the transmit queue goes on a later pass
+void reportTask()
+{
+    MEASUREMENT_RESULT result;
+    if(commandState == COMMAND_ZEROING)
+        return;
+    while(sendResultLine() && getMeasurementResult(&result))
     {
-        isCapacitanceMeasurement = false;
-        setPinValue(HIGHSIDE_R, 0);
-        // Discharge capacitor under test
-        setPinValue(MEAS_C, 1);
-        setPinValue(LOWSIDE_R, 1);
-        waitMicrosecond(DISCHARGE_TIME);
-        chargeTime /= CAPACITANCE_CONST;
-        sprintf(str, "Capacitance = %.2f uF\n", chargeTime);
-        putsUart0(str);
+        if(sortState == SORT_MEASURING)
+            sortPart(&result);
+        else
+            printMeasurementResult(&result);
     }
+}
 
-    if(isInductanceMeasurement)
+// Every ms builds the command line from what uart0Isr() has received, the ISR also does the transmitting
+// The next line is not read in until the command is done with the last one and everything it printed is out,
+// so the reply to a line always has the whole transmit queue
+// Any key stops a stream or a sort, their tasks finish the command
+void uartTask()
+{
+    serviceUart0();
+    if(isStreaming() || sortState != SORT_OFF)
     {
-        isInductanceMeasurement = false;
-        setPinValue(LOWSIDE_R, 0);
-        setPinValue(MEAS_LR, 0);
-        float esr = measureEsr();
-        float inductance = ((R33OHMS / (R33OHMS + esr)) * chargeTime) / INDUCTANCE_CONST;
-        sprintf(str, "Inductance = %.2f uH\n", inductance);
-        putsUart0(str);
+        if(kbhitUart0())
+        {
+            getcUart0();
+            stopStream();
+            stopSort();
+        }
+    }
+    else if(!isLineReady && isUart0QueueEmpty() && tryGetsUart0(&data))
+    {
+        isLineReady = true;
+        commandState = COMMAND_NEW;
+        postEvent(EVENT_LINE_READY);
     }
 }
 
-void measureResistance()
+// Ready for the next line once the command is done
+// The prompt waits for room behind the results still going out, the task runs again on the next pass
+void promptTask()
 {
-    isResistanceMeasurement = true;
-    resetMeasurements();
-    // Discharge the 1uF capacitor
-    setPinValue(INTEGRATE, 1);
-    setPinValue(LOWSIDE_R, 1);
-    waitMicrosecond(DISCHARGE_TIME);
-    COMP_ACINTEN_R |= COMP_ACINTEN_IN0;
-    // Turn of low side r
-    setPinValue(LOWSIDE_R, 0);
-    // Reset timer value and enable interrupts
-    TIMER0_TAV_R = 0;
-    setPinValue(MEAS_LR, 1);
-    TIMER0_CTL_R |= TIMER_CTL_TAEN;
+    if(!queueUart0("DVM> "))
+    {
+        postEvent(EVENT_COMMAND_DONE);
+        return;
+    }
+    isLineReady = false;
 }
 
-void measureCapacitance()
+// True once the engine is idle, otherwise the command waits for it in terminalTask() and runs again
+bool isEngineIdle()
 {
-    isCapacitanceMeasurement = true;
-    resetMeasurements();
-    // Discharge capacitor under test
-    setPinValue(MEAS_C, 1);
-    setPinValue(LOWSIDE_R, 1);
-    waitMicrosecond(DISCHARGE_TIME);
-    setPinValue(LOWSIDE_R, 0);
-    COMP_ACINTEN_R |= COMP_ACINTEN_IN0;
-    // Reset timer value and enable interrupts
-    TIMER0_TAV_R = 0;
-    setPinValue(HIGHSIDE_R, 1);
-    TIMER0_CTL_R |= TIMER_CTL_TAEN;
+    if(isMeasurementIdle())
+        return true;
+    commandState = COMMAND_WAITING;
+    return false;
 }
 
-void measureInductance()
+void printZeroOffsets()
 {
-    isInductanceMeasurement = true;
-    resetMeasurements();
-    setPinValue(LOWSIDE_R, 1);
-    // Reset timer value and enable interrupts
-    TIMER0_TAV_R = 0;
-    COMP_ACINTEN_R |= COMP_ACINTEN_IN0;
-    TIMER0_CTL_R |= TIMER_CTL_TAEN;
-    setPinValue(MEAS_LR, 1);
+    sprintf(str, "Zero = R %u, C %u, L %u counts\n", getZeroOffset(MEASURE_RESISTANCE),
+            getZeroOffset(MEASURE_CAPACITANCE), getZeroOffset(MEASURE_INDUCTANCE));
+    putsUart0(str);
 }
 
-float tAbs(float a, float b)
+// Starts zeroing a type, the readings come back through stepZeroCommand()
+void startZeroCommand(MEASUREMENT_TYPE type)
 {
-    float res = a - b;
-    if(res < 0)
-        res = -res;
-    return res;
+    zeroingType = type;
+    startZero(type);
+    commandState = COMMAND_ZEROING;
 }
 
-#define DEBUG
-
-int main(void)
+// Feeds the zero the readings that are in, zero short does the resistance and then the inductance
+// Returns true once the command is done
+bool stepZeroCommand()
 {
-    initLcrMeter();
-    initTimer();
-    initComparator0();
-    initAdc0Ss3();
-
-    // Use AIN3 input with N=4 hardware sampling
-    setAdc0Ss3Mux(3);
-    setAdc0Ss3Log2AverageCount(2);
+    MEASUREMENT_RESULT result;
+    while(takeMeasurementResult(&result))
+    {
+        if(addZeroReading(&result))
+            continue;
+        if(!isZeroValid(zeroingType))
+            putsUart0(zeroingType == MEASURE_CAPACITANCE ? "Fixture is not open\n" : "Fixture is not shorted\n");
+        else if(zeroingType == MEASURE_RESISTANCE)
+        {
+            startZeroCommand(MEASURE_INDUCTANCE);
+            continue;
+        }
+        printZeroOffsets();
+        return true;
+    }
+    return false;
+}
 
-    initUart0();
-    setUart0BaudRate(115200, 40e6);
+// Runs the parsed line, stream and bin only start their task
+// Returns false if the command is not done yet, it waits for the engine or is zeroing
+bool runCommand()
+{
+    commandState = COMMAND_NONE;
 
-    bool r = false, c = false, l = false;
+    if(isCommand(&data, "auto", 0))
+    {
+        checkMeasurementQueued(measureAuto());
+    }
 
-    USER_DATA data;
+    // stream <r | c | l | auto> [readings per second, 0 = back-to-back]
+    if(isCommand(&data, "stream", 1))
+    {
+        char* component = getFieldString(&data, 1);
+        uint8_t rateField = getFieldInteger(&data, 2);
+        MEASUREMENT_TYPE type = MEASURE_NONE;
+        if(component == 0)
+            type = MEASURE_NONE;
+        else if(stringCompare(component, "r"))
+            type = MEASURE_RESISTANCE;
+        else if(stringCompare(component, "c"))
+            type = MEASURE_CAPACITANCE;
+        else if(stringCompare(component, "l"))
+            type = MEASURE_INDUCTANCE;
+        else if(stringCompare(component, "auto"))
+            type = MEASURE_AUTO;
+        if(type != MEASURE_NONE)
+            startStream(type, rateField ? getInteger(&data, rateField) : 0);
+        else
+            putsUart0("Usage: stream <r | c | l | auto> [rate]\n");
+    }
 
-    // Endless loop
-    while(true)
+    // bin [r | c <nominal> <tolerance %> [tolerance %] [tolerance %]]
+    // Nominal takes a suffix in place of the decimal point, e.g. bin r 4k7 1 5 10 or bin c 2u2 5 10
+    if(isCommand(&data, "bin", 0))
     {
-        putsUart0("DVM> ");
-        getsUart0(&data);
-        parseField(&data);
-        //COMP_ACINTEN_R &= ~COMP_ACINTEN_IN0;
+        char* component = getFieldString(&data, 1);
+        uint8_t nominalField = getFieldInteger(&data, 2);
+        float nominal = nominalField ? getEngineering(&data, nominalField) : 0;
+        uint8_t tolerances[SORT_MAX_BANDS];
+        uint8_t count = 0;
+        bool isInRange = true;
+        MEASUREMENT_TYPE type = MEASURE_NONE;
+
+        if(component != 0 && stringCompare(component, "r"))
+            type = MEASURE_RESISTANCE;
+        else if(component != 0 && stringCompare(component, "c"))
+        {
+            // The engine works in uF
+            type = MEASURE_CAPACITANCE;
+            nominal *= 1e6f;
+        }
+        while(count < SORT_MAX_BANDS && getFieldInteger(&data, 3 + count))
+        {
+            // Checked before it goes into 8 bits, where 300% would come out as 44%
+            uint32_t tolerance = getInteger(&data, getFieldInteger(&data, 3 + count));
+            isInRange &= tolerance <= SORT_MAX_TOLERANCE;
+            tolerances[count] = tolerance;
+            count++;
+        }
 
-        if(isCommand(&data, "auto", 0))
+        if(data.fieldCount == 1)
+            printSortCounts();
+        else if(isInRange && setSortLimits(type, nominal, tolerances, count))
         {
-            r = l = false;
-            setPinValue(LOWSIDE_R, 1);
-            setPinValue(MEAS_LR, 1);
-            startingVoltage = getDut2Voltage();
-            waitMicrosecond(100000);
-            endingVoltage = getDut2Voltage();
-            setPinValue(MEAS_LR, 0);
-            setPinValue(MEAS_C, 1);
-            waitMicrosecond(DISCHARGE_TIME);
-            setPinValue(LOWSIDE_R, 0);
-            setPinValue(MEAS_C, 0);
-
-            resetMeasurements();
-
-            if((tAbs(endingVoltage, startingVoltage) < 0.03))
-            {
-                putsUart0("Might be resistance\n");
-                r = true;
-                l = false;
-            }
+            resetSortCounts();
+            startSort();
+        }
+        else
+            putsUart0("Usage: bin [r | c <nominal> <tolerance %> [tolerance %] [tolerance %]]\n");
+    }
 
-#ifdef DEBUG
-            sprintf(str, "starting voltage = %f, ending voltage = %f, abs = %f\n", startingVoltage, endingVoltage, tAbs(endingVoltage, startingVoltage));
-            putsUart0(str);
-#endif
+    // Measure Resistance/Inductance
+    if(isCommand(&data, "mlr", 0))
+    {
+        checkMeasurementQueued(measureResistance());
+    }
 
-            setPinValue(LOWSIDE_R, 1);
-            setPinValue(MEAS_LR, 1);
-            startingVoltage = getDut2Voltage();
-            endingVoltage = getDut2Voltage();
-            setPinValue(MEAS_LR, 0);
-            setPinValue(MEAS_C, 1);
-            waitMicrosecond(DISCHARGE_TIME);
-            setPinValue(LOWSIDE_R, 0);
-            setPinValue(MEAS_C, 0);
+    // Measure Capacitance
+    if(isCommand(&data, "mc", 0))
+    {
+        checkMeasurementQueued(measureCapacitance());
+    }
 
-            resetMeasurements();
+    // Measure Resistance/Inductance
+    if(isCommand(&data, "mi", 0))
+    {
+        checkMeasurementQueued(measureInductance());
+    }
 
-            if(endingVoltage > startingVoltage)
-            {
-                if(!r)
-                {
-                    putsUart0("This is inductance\n");
-                    l = true;
-                }
-            }
+    // capture [sw | hw]
+    if(isCommand(&data, "capture", 0))
+    {
+        char* mode = getFieldString(&data, 1);
+        // Don't switch timers under a measurement that is already charging
+        if(!isEngineIdle())
+            return false;
+        if(mode != 0 && stringCompare(mode, "sw"))
+            setCaptureMode(CAPTURE_SOFTWARE);
+        else if(mode != 0 && stringCompare(mode, "hw"))
+            setCaptureMode(CAPTURE_HARDWARE);
+        putsUart0(getCaptureMode() == CAPTURE_HARDWARE ? "Capture = hw (WT1CCP0)\n" : "Capture = sw (comparator ISR)\n");
+    }
 
-            if(r && !l)
-                measureResistance();
-            if(!r && l)
-                measureInductance();
-            if(!r && !l)
-                measureCapacitance();
+    // threshold [single | dual]
+    if(isCommand(&data, "threshold", 0))
+    {
+        char* mode = getFieldString(&data, 1);
+        // The comparator 0 reference moves, so let the measurement in progress finish first
+        if(!isEngineIdle())
+            return false;
+        if(mode != 0 && stringCompare(mode, "single"))
+            setThresholdMode(THRESHOLD_SINGLE);
+        else if(mode != 0 && stringCompare(mode, "dual"))
+            setThresholdMode(THRESHOLD_DUAL);
+        putsUart0(getThresholdMode() == THRESHOLD_DUAL ? "Threshold = dual (COMP1 to COMP0)\n" : "Threshold = single (COMP0)\n");
+    }
+
+    // fit [on | off] [end mV]
+    if(isCommand(&data, "fit", 0))
+    {
+        char* mode = getFieldString(&data, 1);
+        uint8_t endField = getFieldInteger(&data, 2);
+        if(!isEngineIdle())
+            return false;
+        if(mode != 0 && stringCompare(mode, "on"))
+            setCapacitanceFit(true);
+        else if(mode != 0 && stringCompare(mode, "off"))
+            setCapacitanceFit(false);
+        if(endField)
+            setChargeFitEnd(getInteger(&data, endField));
+        sprintf(str, "Capacitance fit = %s, end = %u mV\n", getCapacitanceFit() ? "on" : "off", getChargeFitEnd());
+        putsUart0(str);
+    }
 
+    // discharge [fixed | adaptive <threshold mV>]
+    if(isCommand(&data, "discharge", 0))
+    {
+        char* mode = getFieldString(&data, 1);
+        uint8_t thresholdField = getFieldInteger(&data, 2);
+        if(mode != 0 && stringCompare(mode, "fixed"))
+            setDischargeMode(DISCHARGE_FIXED, getDischargeThreshold());
+        else if(mode != 0 && stringCompare(mode, "adaptive"))
+            setDischargeMode(DISCHARGE_ADAPTIVE, thresholdField ? getInteger(&data, thresholdField) : getDischargeThreshold());
+        sprintf(str, "Discharge = %s, threshold = %u mV\n",
+                getDischargeMode() == DISCHARGE_ADAPTIVE ? "adaptive" : "fixed", getDischargeThreshold());
+        putsUart0(str);
+    }
 
+    // stats [clear], on the readings kept in the history
+    if(isCommand(&data, "stats", 0))
+    {
+        char* mode = getFieldString(&data, 1);
+        if(mode != 0 && stringCompare(mode, "clear"))
+        {
+            if(!clearHistory())
+                putsUart0("History is being dumped, try again\n");
         }
+        else
+            printHistoryStats();
+    }
+
+    // dump, the history as a binary frame (see history.h), the prompt follows it
+    // The readings already asked for are in it, new ones go on while it is sent
+    if(isCommand(&data, "dump", 0))
+    {
+        if(!isEngineIdle())
+            return false;
+        dumpHistory();
+    }
 
-        // Measure Resistance/Inductance
-        if(isCommand(&data, "mlr", 0))
+    // baud [rate], the new rate takes effect once everything before it has gone out
+    // Above 2.5 Mbaud the UART uses high speed mode, rates that can't be made within 2% are refused
+    if(isCommand(&data, "baud", 0))
+    {
+        uint8_t rateField = getFieldInteger(&data, 1);
+        if(rateField && !setUart0BaudRate(getInteger(&data, rateField), SYSTEM_CLOCK_HZ))
+            putsUart0("Baud rate is out of range\n");
+        sprintf(str, "Baud = %lu, error = %ld ppm%s\n", (unsigned long)getUart0BaudRate(), (long)getUart0BaudError(),
+                isUart0HighSpeed() ? ", high speed" : "");
+        putsUart0(str);
+    }
+
+    // prof [clear], cycle counts of the phases of a measurement
+    if(isCommand(&data, "prof", 0))
+    {
+        char* mode = getFieldString(&data, 1);
+        if(mode != 0 && stringCompare(mode, "clear"))
         {
-            measureResistance();
+#ifdef PROFILE
+            clearProfile();
+#endif
         }
+        else
+            printProfile();
+    }
 
-        // Measure Capacitance
-        if(isCommand(&data, "mc", 0))
+    // zero [open | short | clear]
+    // open takes the stray capacitance of the empty fixture, short the lead resistance and inductance
+    if(isCommand(&data, "zero", 0))
+    {
+        char* mode = getFieldString(&data, 1);
+        if(!isEngineIdle())
+            return false;
+        if(mode != 0 && stringCompare(mode, "open"))
         {
-            measureCapacitance();
+            startZeroCommand(MEASURE_CAPACITANCE);
+            return false;
         }
-
-        // Measure Resistance/Inductance
-        if(isCommand(&data, "mi", 0))
+        if(mode != 0 && stringCompare(mode, "short"))
         {
-            measureInductance();
+            startZeroCommand(MEASURE_RESISTANCE);
+            return false;
         }
+        if(mode != 0 && stringCompare(mode, "clear"))
+            clearZeroOffsets();
+        printZeroOffsets();
+    }
 
-        if(isCommand(&data, "v", 0))
+    // temp [on | off | coef <r | c | l> <ppm per C>], the temperature of the last measurement and its compensation
+    if(isCommand(&data, "temp", 0))
+    {
+        char* mode = getFieldString(&data, 1);
+        float tenths = getTemperature() * 10;
+        if(mode != 0 && stringCompare(mode, "on"))
+            setTemperatureCompensation(true);
+        else if(mode != 0 && stringCompare(mode, "off"))
+            setTemperatureCompensation(false);
+        else if(mode != 0 && stringCompare(mode, "coef"))
         {
-            resetMeasurements();
-            setPinValue(MEAS_LR, 1);
-            setPinValue(LOWSIDE_R, 1);
-            waitMicrosecond(1000);
-            float esr = readDutResistance();
-            sprintf(str, "ESR of device = %.2f Ohm\n", esr);
-            putsUart0(str);
-            setPinValue(MEAS_LR, 0);
-            setPinValue(LOWSIDE_R, 0);
+            char* component = getFieldString(&data, 2);
+            uint8_t ppmField = getFieldInteger(&data, 3);
+            MEASUREMENT_TYPE type = MEASURE_NONE;
+            if(component != 0 && stringCompare(component, "r"))
+                type = MEASURE_RESISTANCE;
+            else if(component != 0 && stringCompare(component, "c"))
+                type = MEASURE_CAPACITANCE;
+            else if(component != 0 && stringCompare(component, "l"))
+                type = MEASURE_INDUCTANCE;
+            if(type != MEASURE_NONE && ppmField)
+                setTemperatureCoefficient(type, getSignedInteger(&data, ppmField));
+            else
+                putsUart0("Usage: temp coef <r | c | l> <ppm>\n");
         }
+        char* end = formatString(str, "Temperature = ");
+        end = formatFixed(end, tenths + ((tenths < 0) ? -0.5f : 0.5f), 1);
+        end = formatString(end, " C, compensation = ");
+        formatString(end, getTemperatureCompensation() ? "on\n" : "off\n");
+        putsUart0(str);
+        sprintf(str, "Coefficients = R %d, C %d, L %d ppm/C\n", getTemperatureCoefficient(MEASURE_RESISTANCE),
+                getZeroOffset(MEASURE_CAPACITANCE), getZeroOffset(MEASURE_INDUCTANCE));
+        putsUart0(str);
+    }
+
+    // esr [on | off | clear] [refresh readings, 0 = only when the part changes]
+    if(isCommand(&data, "esr", 0))
+    {
+        char* mode = getFieldString(&data, 1);
+        uint8_t refreshField = getFieldInteger(&data, 2);
+        uint16_t refresh = refreshField ? getInteger(&data, refreshField) : getEsrRefresh();
+        if(!isEngineIdle())
+            return false;
+        if(mode != 0 && stringCompare(mode, "on"))
+            setEsrCache(true, refresh);
+        else if(mode != 0 && stringCompare(mode, "off"))
+            setEsrCache(false, refresh);
+        else if(mode != 0 && stringCompare(mode, "clear"))
+            clearEsrCache();
+        sprintf(str, "ESR cache = %s, refresh = %u readings\n", getEsrCache() ? "on" : "off", getEsrRefresh());
+        putsUart0(str);
     }
+
+    if(isCommand(&data, "v", 0))
+    {
+        if(!isEngineIdle())
+            return false;
+        resetMeasurements();
+        float esr = measureEsr();
+        char* end = formatString(str, "ESR of device = ");
+        end = formatEngineering(end, esr, "Ohm");
+        formatString(end, "\n");
+        putsUart0(str);
+    }
+
+    return true;
+}
+
+// Runs every ms and on a new line or a result, only while there is a command to run or to finish
+void terminalTask()
+{
+    bool isDone = false;
+
+    switch(commandState)
+    {
+        case COMMAND_NONE:
+            return;
+        case COMMAND_NEW:
+            parseField(&data);
+            //COMP_ACINTEN_R &= ~COMP_ACINTEN_IN0;
+            isDone = runCommand();
+            break;
+        case COMMAND_WAITING:
+            isDone = isMeasurementIdle() && runCommand();
+            break;
+        case COMMAND_ZEROING:
+            isDone = stepZeroCommand();
+            if(isDone)
+                commandState = COMMAND_NONE;
+            break;
+    }
+
+    // A stream or a sort finishes the command from its own task
+    if(isDone && !isStreaming() && sortState == SORT_OFF)
+        postEvent(EVENT_COMMAND_DONE);
+}
+
+int main(void)
+{
+    initLcrMeter();
+    initTimer();
+    initComparator0();
+    initComparator1();
+    initAdc0Ss3();
+    initChargeFit();
+    initSorter();
+
+    // Use AIN3 input with N=4 hardware sampling
+    setAdc0Ss3Mux(3);
+    setAdc0Ss3Log2AverageCount(2);
+    // The esr inputs are read together on SS1 (the averaging applies to every sequencer)
+    initEsrSequence();
+
+    initUart0();
+    setUart0BaudRate(115200, SYSTEM_CLOCK_HZ);
+    // Results go out in the background, the measurement never waits on the terminal
+    enableUart0Interrupts();
+    // History dumps go out on uDMA
+    enableUart0Dma();
+
+    initSystickTimer();
+#ifdef PROFILE
+    initProfiler();
+#endif
+
+    data.count = 0;
+    addTask(measurementTask, EVENT_MASK(EVENT_MEASURE));
+    addTimedTask(reportTask, 1, EVENT_MASK(EVENT_RESULT));
+    addTimedTask(terminalTask, 1, EVENT_MASK(EVENT_LINE_READY) | EVENT_MASK(EVENT_RESULT));
+    addTask(promptTask, EVENT_MASK(EVENT_COMMAND_DONE));
+    addTimedTask(uartTask, 1, 0);
+    addTimedTask(streamTask, 1, EVENT_MASK(EVENT_STREAM));
+    addTimedTask(sortTask, 1, EVENT_MASK(EVENT_SORT));
+
+    putsUart0("DVM> ");
+    runScheduler();
 }
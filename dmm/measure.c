@@ -0,0 +1,1361 @@
+// Measurement Library
+// Sarker Nadir Afridi Azmi
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Hardware configuration:
+// Analog Comparator 0 (C0- on PC7) watching DUT2
+// Analog Comparator 1 (C1- on PC4) jumpered to DUT2, C1+ (PC5) on a 10k/3.3k divider from 3.3V
+// Wide Timer 0 (64-bit) measures the charge time, Timer 1 times the discharge/settle phases (timer1Isr)
+// Hardware capture: C0o (PF0) jumpered to WT1CCP0 (PC6), Wide Timer 1A in edge time mode (48-bit)
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include "tm4c123gh6pm.h"
+#include "clock.h"
+#include "gpio.h"
+#include "wait.h"
+#include "adc0.h"
+#include "fit.h"
+#include "measure.h"
+#include "history.h"
+#include "profile.h"
+#include "scheduler.h"
+
+// Timer ticks per microsecond
+#define CLOCKS_PER_US           (SYSTEM_CLOCK_HZ / 1000000)
+
+#define ABS(N) (((N)<0)?(-(N)):(N))
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+// Only the main loop touches the request queue, the ISR only advances CHARGE -> CAPTURE
+MEASUREMENT_TYPE requestQueue[MEASUREMENT_QUEUE_SIZE];
+uint8_t requestHead = 0;
+uint8_t requestTail = 0;
+
+volatile MEASUREMENT_STATE state = STATE_IDLE;
+MEASUREMENT_TYPE currentType = MEASURE_NONE;
+
+// Raw ADC readings behind the inductor esr, taken in STATE_ESR
+uint16_t esrQ3Vc = 0;
+uint16_t esrQ7Vc = 0;
+uint16_t esrDut2 = 0;
+
+// Internal temperature sensor, sampled on SS1 at the start of every measurement
+uint16_t temperatureRaw = 0;
+bool isTemperaturePending = false;
+bool isTemperatureCompensated = true;
+int16_t temperatureCoefficients[MEASURE_AUTO] = {0, RESISTANCE_TEMPCO_PPM, CAPACITANCE_TEMPCO_PPM, INDUCTANCE_TEMPCO_PPM};
+
+// The esr inputs above are kept for the next inductance readings of the same part
+// esrCachedCount is the charge count of the first reading made with them
+bool isEsrCacheEnabled = true;
+bool isEsrCached = false;
+uint16_t esrRefreshReadings = ESR_REFRESH_READINGS;
+uint16_t esrCachedReadings = 0;
+uint64_t esrCachedCount = 0;
+bool isEsrRetry = false;
+
+// Single producer (the capture ISR), single consumer (getMeasurementResult() in the main loop)
+// The engine moves on to the next request as soon as a record is pushed
+// The main loop ends a charge itself on a timeout or a curve fit, it masks interrupts around
+// captureMeasurement() so it never pushes while a capture ISR is in the middle of it
+CAPTURE_RECORD captureQueue[CAPTURE_QUEUE_SIZE];
+volatile uint8_t captureHead = 0;
+volatile uint8_t captureTail = 0;
+volatile uint16_t droppedCaptures = 0;
+
+// Large capacitors can be measured from the start of the charge curve instead of the comparator
+bool isCapacitanceFitEnabled = false;
+bool isFitCapture = false;
+float fitTau = 0;
+
+// Charge phase bounds, DUT2 at the start of the charge and whether the probe has passed
+// The phase timer only reaches 107 s, longer timeouts run it several times
+uint16_t chargeStartRaw = 0;
+bool isChargeProbed = false;
+uint32_t chargeTimeLeft = 0;
+MEASUREMENT_STATUS captureStatus = RESULT_OK;
+
+// Auto measurements classify the DUT before measuring it
+typedef enum _CLASSIFY_PHASE
+{
+    CLASSIFY_LR,
+    CLASSIFY_LR_LONG,
+    CLASSIFY_C,
+    CLASSIFY_C_LONG
+} CLASSIFY_PHASE;
+
+CLASSIFY_PHASE classifyPhase = CLASSIFY_LR;
+bool isAutoMeasurement = false;
+float classifyConfidence = 0;
+// Shortest discharge (us) after the last classification burst, 0 outside an auto measurement
+uint32_t classifyDischargeTime = 0;
+
+CAPTURE_MODE captureMode = CAPTURE_SOFTWARE;
+
+// Residual counts of the fixture (open for capacitance, shorted for resistance and inductance),
+// taken off every raw count, indexed by MEASUREMENT_TYPE
+uint32_t zeroOffsets[MEASURE_AUTO] = {0, 0, 0, 0};
+bool isZeroed[MEASURE_AUTO] = {false, false, false, false};
+// The zero in progress, fed one reading at a time by addZeroReading()
+MEASUREMENT_TYPE zeroType = MEASURE_NONE;
+uint8_t zeroReadings = 0;
+uint64_t zeroSum = 0;
+bool isZeroEmpty = true;
+
+// Dual threshold timing, the count when DUT2 crossed the lower threshold (comparator1Isr())
+THRESHOLD_MODE thresholdMode = THRESHOLD_SINGLE;
+volatile uint64_t lowerCount = 0;
+volatile bool isLowerCaptured = false;
+
+DISCHARGE_MODE dischargeMode = DISCHARGE_ADAPTIVE;
+uint16_t dischargeThresholdMv = DISCHARGE_THRESHOLD_MV;
+// The threshold in ADC counts so the discharge poll needs no floating point
+uint16_t dischargeThresholdRaw = (DISCHARGE_THRESHOLD_MV * 4096) / (VSUPPLY * 1000);
+// When the discharge phase started (us), how long it has to last at least and the settle once DUT2 is below the threshold
+uint32_t dischargeStart = 0;
+uint32_t dischargeMinimum = 0;
+bool isDischargeSettling = false;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initLcrMeter()
+{
+    initSystemClockTo40Mhz();
+
+    enablePort(PORTA);
+    enablePort(PORTB);
+    enablePort(PORTE);
+
+    selectPinPushPullOutput(MEAS_LR);
+    selectPinPushPullOutput(INTEGRATE);
+    selectPinPushPullOutput(LOWSIDE_R);
+    selectPinPushPullOutput(HIGHSIDE_R);
+    selectPinPushPullOutput(MEAS_C);
+
+    selectPinAnalogInput(AIN3);
+    selectPinAnalogInput(AIN2);
+    selectPinAnalogInput(AIN1);
+}
+
+void resetMeasurements()
+{
+    setPinValue(MEAS_LR, 0);
+    setPinValue(MEAS_C, 0);
+    setPinValue(INTEGRATE, 0);
+    setPinValue(LOWSIDE_R, 0);
+    setPinValue(HIGHSIDE_R, 0);
+}
+
+void initTimer()
+{
+    SYSCTL_RCGCTIMER_R |= SYSCTL_RCGCTIMER_R1;
+    SYSCTL_RCGCWTIMER_R |= SYSCTL_RCGCWTIMER_R0 | SYSCTL_RCGCWTIMER_R1;
+    _delay_cycles(3);
+
+    // Wide Timer 0 counts the charge time in 64 bits, it can't wrap in any measurement
+    WTIMER0_CTL_R &= ~TIMER_CTL_TAEN;                // turn-off timer before reconfiguring
+    WTIMER0_CFG_R = TIMER_CFG_32_BIT_TIMER;          // configure as 64-bit timer (A+B)
+    WTIMER0_TAMR_R = TIMER_TAMR_TAMR_1_SHOT | TIMER_TAMR_TACDIR;
+                                                     // configure for one-shot mode (count up)
+    WTIMER0_TAILR_R = 0xFFFFFFFF;                    // count up over the full 64-bit range
+    WTIMER0_TBILR_R = 0xFFFFFFFF;
+
+    // Timer 1 times the discharge and settle phases, its interrupt only wakes measurementTask
+    TIMER1_CTL_R &= ~TIMER_CTL_TAEN;                 // turn-off timer before reconfiguring
+    TIMER1_CFG_R = TIMER_CFG_32_BIT_TIMER;           // configure as 32-bit timer (A+B)
+    TIMER1_TAMR_R = TIMER_TAMR_TAMR_1_SHOT;          // configure for one-shot mode (count down)
+    TIMER1_IMR_R = 0;                                // timeout interrupt is turned on by startPhaseTimer()
+    // Vector Number = 37, Interrupt Number = 21
+    NVIC_EN0_R |= 1 << (INT_TIMER1A-16);
+
+    // Wide Timer 1A latches the count on the rising edge of C0o, jumpered from PF0 to WT1CCP0 (PC6)
+    enablePort(PORTC);
+    selectPinDigitalInput(COMPARATOR0_CAPTURE);
+    setPinAuxFunction(COMPARATOR0_CAPTURE, GPIO_PCTL_PC6_WT1CCP0);
+
+    WTIMER1_CTL_R &= ~TIMER_CTL_TAEN;                // turn-off timer before reconfiguring
+    WTIMER1_CFG_R = TIMER_CFG_16_BIT;                // configure as 32-bit timer (A only)
+    WTIMER1_TAMR_R = TIMER_TAMR_TAMR_CAP | TIMER_TAMR_TACMR | TIMER_TAMR_TACDIR;
+                                                     // configure for edge time mode, count up
+    WTIMER1_CTL_R = TIMER_CTL_TAEVENT_POS;           // measure time from start to positive edge
+    WTIMER1_TAILR_R = 0xFFFFFFFF;                    // count up over the full 48-bit range,
+    WTIMER1_TAPR_R = 0xFFFF;                         // the prescaler extends the count in edge time mode
+    WTIMER1_IMR_R = 0;                               // capture interrupt is turned on when armed
+    // Vector Number = 112, Interrupt Number = 96
+    NVIC_EN3_R |= 1 << (INT_WTIMER1A-16-96);
+}
+
+void initComparator0()
+{
+    // Provide a clock to the Analog Comparator module
+    SYSCTL_RCGCACMP_R |= SYSCTL_RCGCACMP_R0;
+    _delay_cycles(3);
+
+    enablePort(PORTC);
+    selectPinAnalogInput(ANALOG_COMPARATOR0);
+
+    /*
+     * Use the internal reference voltage
+     * VIN- > VIN+, VOUT = 0; We want to invert the output so that the interrupt is triggered when the output is 1
+     * Trigger interrupt on rising edge and when comparator output is high
+     */
+    COMP_ACCTL0_R |= COMP_ACCTL0_ASRCP_REF | COMP_ACCTL0_ISEN_RISE | COMP_ACCTL0_CINV;
+    // Enable resistor ladder and use a reference voltage of 2.469V
+    COMP_ACREFCTL_R |= COMP_ACREFCTL_EN | COMP_ACREFCTL_VREF_M;
+    waitMicrosecond(10);
+    // Turn off interrupts
+    COMP_ACINTEN_R &= ~COMP_ACINTEN_IN0;
+    // Vector Number = 41, Interrupt Number = 25
+    NVIC_EN0_R |= 1 << (INT_COMP0-16);
+
+    // Drive the comparator output on C0o (PF0) so Wide Timer 1 can capture the edge in hardware
+    // PF0 is locked (NMI), so it has to be unlocked before the alternate function can be selected
+    enablePort(PORTF);
+    setPinCommitControl(COMPARATOR0_OUTPUT);
+    selectPinPushPullOutput(COMPARATOR0_OUTPUT);
+    setPinAuxFunction(COMPARATOR0_OUTPUT, GPIO_PCTL_PF0_C0O);
+}
+
+// Comparator 1 only gives the lower threshold of dual threshold timing, its reference is the divider on C1+
+void initComparator1()
+{
+    SYSCTL_RCGCACMP_R |= SYSCTL_RCGCACMP_R0;
+    _delay_cycles(3);
+
+    enablePort(PORTC);
+    selectPinAnalogInput(ANALOG_COMPARATOR1);
+    selectPinAnalogInput(COMPARATOR1_REFERENCE);
+
+    // Same sense as comparator 0, the output goes high when DUT2 rises past C1+
+    COMP_ACCTL1_R = COMP_ACCTL1_ASRCP_PIN | COMP_ACCTL1_ISEN_RISE | COMP_ACCTL1_CINV;
+    waitMicrosecond(10);
+    COMP_ACINTEN_R &= ~COMP_ACINTEN_IN1;
+    // Vector Number = 42, Interrupt Number = 26
+    NVIC_EN0_R |= 1 << (INT_COMP1-16);
+}
+
+// The capture latency is part of the zero offsets, so they have to be taken again
+void setCaptureMode(CAPTURE_MODE mode)
+{
+    captureMode = mode;
+    clearZeroOffsets();
+}
+
+CAPTURE_MODE getCaptureMode()
+{
+    return captureMode;
+}
+
+// Moves comparator 0 to the upper threshold of the mode, only call this with no measurement running
+// The zero offsets are counts of the old mode and are cleared
+void setThresholdMode(THRESHOLD_MODE mode)
+{
+    thresholdMode = mode;
+    clearZeroOffsets();
+    COMP_ACREFCTL_R = COMP_ACREFCTL_EN | ((mode == THRESHOLD_DUAL) ? DUAL_UPPER_TAP : COMP_ACREFCTL_VREF_M);
+    waitMicrosecond(10);
+}
+
+THRESHOLD_MODE getThresholdMode()
+{
+    return thresholdMode;
+}
+
+// Dual threshold timing needs both crossings on the same timer, so it always timestamps in the ISRs
+bool isHardwareCapture()
+{
+    return (captureMode == CAPTURE_HARDWARE) && (thresholdMode == THRESHOLD_SINGLE);
+}
+
+// Starts a one-shot phase of the given length, check it with isPhaseTimerExpired()
+void startPhaseTimer(uint32_t us)
+{
+    TIMER1_CTL_R &= ~TIMER_CTL_TAEN;
+    TIMER1_TAILR_R = us * CLOCKS_PER_US;
+    TIMER1_ICR_R = TIMER_ICR_TATOCINT;
+    TIMER1_IMR_R |= TIMER_IMR_TATOIM;
+    TIMER1_CTL_R |= TIMER_CTL_TAEN;
+}
+
+bool isPhaseTimerExpired()
+{
+    return TIMER1_RIS_R & TIMER_RIS_TATORIS;
+}
+
+// Wakes measurementTask at the end of a phase, the flag is left set for isPhaseTimerExpired()
+void timer1Isr()
+{
+    TIMER1_IMR_R &= ~TIMER_IMR_TATOIM;
+    postEvent(EVENT_MEASURE);
+}
+
+void setDischargeMode(DISCHARGE_MODE mode, uint16_t thresholdMv)
+{
+    dischargeMode = mode;
+    dischargeThresholdMv = thresholdMv;
+    dischargeThresholdRaw = (thresholdMv * 4096) / (VSUPPLY * 1000);
+}
+
+DISCHARGE_MODE getDischargeMode()
+{
+    return dischargeMode;
+}
+
+uint16_t getDischargeThreshold()
+{
+    return dischargeThresholdMv;
+}
+
+uint16_t readDut2Raw()
+{
+    setAdc0Ss3Mux(3);
+    return readAdc0Ss3();
+}
+
+// Returns true once DUT2 has dropped below the discharge threshold
+// The ADC stops at 0 V, so a part still charged the other way reads as discharged too
+bool isDut2Discharged()
+{
+    return readDut2Raw() <= dischargeThresholdRaw;
+}
+
+// Starts the discharge phase, the pins have to be set already
+// An adaptive discharge lasts at least minimum us, DISCHARGE_TIME stays the upper bound
+// It checks DUT2 each time the phase timer runs out, every DISCHARGE_POLL_TIME
+void startDischarge(uint32_t minimum)
+{
+    startPhaseTimer(dischargeMode == DISCHARGE_ADAPTIVE ? DISCHARGE_POLL_TIME : DISCHARGE_TIME);
+    dischargeStart = getMicroseconds();
+    dischargeMinimum = minimum;
+    isDischargeSettling = false;
+}
+
+// Called with the discharge pins already set, returns true when the discharge phase is over
+// Reaching the threshold still leaves up to the threshold on DUT2, which would start the next
+// charge early, so the discharge goes on for a share of the time it took to get there
+bool isDischargeDone()
+{
+    if(!isPhaseTimerExpired())
+        return false;
+    if(dischargeMode != DISCHARGE_ADAPTIVE || isDischargeSettling)
+        return true;
+
+    uint32_t elapsed = getMicroseconds() - dischargeStart;
+    if(elapsed >= DISCHARGE_TIME)
+        return true;
+    if(!isDut2Discharged())
+    {
+        uint32_t left = DISCHARGE_TIME - elapsed;
+        startPhaseTimer(left < DISCHARGE_POLL_TIME ? left : DISCHARGE_POLL_TIME);
+        return false;
+    }
+    uint32_t settle = (elapsed * DISCHARGE_SETTLE_PERCENT) / 100;
+    if(elapsed + settle < dischargeMinimum)
+        settle = dischargeMinimum - elapsed;
+    if(elapsed + settle > DISCHARGE_TIME)
+        settle = DISCHARGE_TIME - elapsed;
+    if(settle == 0)
+        return true;
+    startPhaseTimer(settle);
+    isDischargeSettling = true;
+    return false;
+}
+
+// Starts SS1 for the temperature, the result is picked up by finishTemperatureRead() with no wait
+void startTemperatureRead()
+{
+    if(isTemperaturePending)
+        return;
+    startAdc0Ss1();
+    isTemperaturePending = true;
+}
+
+void finishTemperatureRead()
+{
+    int16_t samples[ESR_SAMPLE_COUNT];
+    if(!isTemperaturePending)
+        return;
+    getAdc0Ss1Results(samples);
+    temperatureRaw = samples[3];
+    isTemperaturePending = false;
+}
+
+// Reads the collector of Q3, the collector of Q7 and DUT2 for the esr calculation
+// All three come from one SS1 trigger, so DUT2 has no time to move between the reads
+void readEsrInputs(uint16_t* q3Vc, uint16_t* q7Vc, uint16_t* dut2)
+{
+    int16_t samples[ESR_SAMPLE_COUNT];
+    // Empty the FIFO of a temperature read still in it
+    finishTemperatureRead();
+    readAdc0Ss1(samples);
+    *q3Vc = samples[0];
+    *q7Vc = samples[1];
+    *dut2 = samples[2];
+    temperatureRaw = samples[3];
+}
+
+// Program SS1 with the esr inputs: Q3 collector (AIN1), Q7 collector (AIN2), DUT2 (AIN3)
+// and the internal temperature sensor
+void initEsrSequence()
+{
+    const uint8_t inputs[ESR_SAMPLE_COUNT] = {1, 2, 3, ADC0_INPUT_TS};
+    initAdc0Ss1();
+    setAdc0Ss1Mux(inputs, ESR_SAMPLE_COUNT);
+}
+
+/*
+ * Use the voltage divider rule to find small values of R
+ * R1 / R2 = V1 / V2
+ * V1 = Q7Vc - DUT2
+ * V2 = DUT2 - Q3Vc
+ * R2 = 32.7 Ohm's
+ */
+float calculateEsr(uint16_t RQ3Vc, uint16_t RQ7Vc, uint16_t Rdut2)
+{
+    float q3Vc = (VSUPPLY * (RQ3Vc + 0.5)) / 4096.0;
+    float q7Vc = (VSUPPLY * (RQ7Vc + 0.5)) / 4096.0;
+    float dut2 = (VSUPPLY * (Rdut2 + 0.5)) / 4096.0;
+    float dut2ResistancePd = q7Vc - dut2;
+    // Reuse dut2ResistancePd to save stack space
+    // This is the esr we are trying to calculate
+    dut2ResistancePd = (dut2ResistancePd / (dut2 - q3Vc)) * R33OHMS;
+    return dut2ResistancePd;
+}
+
+/*
+ * This function returns the resistance of the device under test
+ * This only works for small values of R where R < 100 Ohm's
+ */
+float readDutResistance()
+{
+    uint16_t RQ3Vc, RQ7Vc, Rdut2;
+    readEsrInputs(&RQ3Vc, &RQ7Vc, &Rdut2);
+    return calculateEsr(RQ3Vc, RQ7Vc, Rdut2);
+}
+
+// Blocking ESR read, only used by the terminal, measurements go through STATE_ESR
+float measureEsr()
+{
+    float esr = 0.00;
+    // Measure the esr
+    setPinValue(MEAS_LR, 1);
+    setPinValue(LOWSIDE_R, 1);
+    waitMicrosecond(ESR_SETTLE_TIME);
+    esr = readDutResistance();
+    setPinValue(MEAS_LR, 0);
+    setPinValue(LOWSIDE_R, 0);
+    return esr;
+}
+
+void setEsrCache(bool enabled, uint16_t refreshReadings)
+{
+    isEsrCacheEnabled = enabled;
+    esrRefreshReadings = refreshReadings;
+    isEsrCached = false;
+}
+
+bool getEsrCache()
+{
+    return isEsrCacheEnabled;
+}
+
+uint16_t getEsrRefresh()
+{
+    return esrRefreshReadings;
+}
+
+// The next inductance reading measures the esr again
+void clearEsrCache()
+{
+    isEsrCached = false;
+}
+
+bool isEsrCacheValid()
+{
+    if(!isEsrCacheEnabled || !isEsrCached)
+        return false;
+    return esrRefreshReadings == 0 || esrCachedReadings < esrRefreshReadings;
+}
+
+// Returns false if the reading just made on a cached esr looks like a different part
+// Any other measurement, or one that found the fixture open or out of range, drops the cache
+bool checkEsrCache(uint64_t count)
+{
+    if(currentType != MEASURE_INDUCTANCE || captureStatus != RESULT_OK)
+    {
+        isEsrCached = false;
+        return true;
+    }
+    if(!isEsrCached)
+        return true;
+    if(esrCachedReadings == 0)
+        esrCachedCount = count;
+    else
+    {
+        // Absolute difference without going through a signed type
+        uint64_t change = (count > esrCachedCount) ? count - esrCachedCount : esrCachedCount - count;
+        if(change * 100 > esrCachedCount * ESR_CHANGE_PERCENT)
+        {
+            isEsrCached = false;
+            return false;
+        }
+    }
+    esrCachedReadings++;
+    return true;
+}
+
+// Queues the raw data of the measurement for getMeasurementResult()
+// A full queue drops the record, the measurement itself still completes
+void pushCaptureRecord(uint64_t count)
+{
+    uint8_t next = (captureHead + 1) & (CAPTURE_QUEUE_SIZE - 1);
+    if(next == captureTail)
+    {
+        droppedCaptures++;
+        return;
+    }
+
+    CAPTURE_RECORD* record = &captureQueue[captureHead];
+    record->type = currentType;
+    record->status = captureStatus;
+    record->count = count;
+    record->esrQ3Vc = esrQ3Vc;
+    record->esrQ7Vc = esrQ7Vc;
+    record->esrDut2 = esrDut2;
+    record->temperatureRaw = temperatureRaw;
+    record->time = getMilliseconds();
+    record->isAuto = isAutoMeasurement;
+    record->confidence = classifyConfidence;
+    record->isFit = isFitCapture;
+    record->isDual = (thresholdMode == THRESHOLD_DUAL);
+    record->fitTau = fitTau;
+    captureHead = next;
+    postEvent(EVENT_RESULT);
+}
+
+// Ends the charge phase, called from the capture ISRs (or the main loop for a charge curve fit)
+// Only flips pins and queues the raw record, nothing in here waits or formats
+void captureMeasurement(uint64_t count)
+{
+    if(state != STATE_CHARGE)
+        return;
+
+    switch(currentType)
+    {
+        case MEASURE_RESISTANCE:
+            setPinValue(MEAS_LR, 0);
+            // Discharge the 1uF capacitor
+            setPinValue(INTEGRATE, 1);
+            setPinValue(LOWSIDE_R, 1);
+            break;
+        case MEASURE_CAPACITANCE:
+            setPinValue(HIGHSIDE_R, 0);
+            // Start discharging the capacitor under test, the next measurement finishes the job
+            setPinValue(MEAS_C, 1);
+            setPinValue(LOWSIDE_R, 1);
+            break;
+        case MEASURE_INDUCTANCE:
+            setPinValue(LOWSIDE_R, 0);
+            setPinValue(MEAS_LR, 0);
+            break;
+        default:
+            break;
+    }
+
+    // A new part on a stale esr is measured again from the esr phase, nothing is reported
+    isEsrRetry = !checkEsrCache(count);
+    if(!isEsrRetry)
+    {
+        pushCaptureRecord(count);
+        PROFILE_STOP(PROBE_MEASUREMENT);
+    }
+    state = STATE_CAPTURE;
+    postEvent(EVENT_MEASURE);
+}
+
+// Reads the 64-bit count of Wide Timer 0, the lower half goes first since it is the timestamp
+// If it wrapped before the upper half was read, the upper half is re-read (now surely past the wrap) and taken back by one
+uint64_t readWideTimer0()
+{
+    uint32_t low = WTIMER0_TAV_R;
+    uint32_t high = WTIMER0_TBV_R;
+    if(WTIMER0_TAV_R < low)
+        high = WTIMER0_TBV_R - 1;
+    return ((uint64_t)high << 32) | low;
+}
+
+// Records the timer value after the comparator reaches 2.469V (DUAL_UPPER_VREF with dual threshold timing)
+// The count includes the interrupt entry latency, see wideTimer1Isr() for the hardware capture
+void comparator0Isr()
+{
+    uint64_t count = readWideTimer0();
+    PROFILE_START(PROBE_CAPTURE_ISR);
+    // Clear the interrupt flag, only this one, the flag of comparator 1 may still be pending
+    COMP_ACMIS_R = COMP_ACMIS_IN0;
+    COMP_ACINTEN_R &= ~(COMP_ACINTEN_IN0 | COMP_ACINTEN_IN1);
+    WTIMER0_CTL_R &= ~TIMER_CTL_TAEN;
+
+    // Time between the thresholds, both crossings came in together if the lower one is missing
+    if(thresholdMode == THRESHOLD_DUAL)
+        count = isLowerCaptured ? count - lowerCount : 0;
+    captureMeasurement(count);
+    PROFILE_STOP(PROBE_CAPTURE_ISR);
+}
+
+// Records the timer value when DUT2 crosses the lower threshold, the charge carries on to comparator 0
+void comparator1Isr()
+{
+    uint64_t count = readWideTimer0();
+    COMP_ACMIS_R = COMP_ACMIS_IN1;
+    COMP_ACINTEN_R &= ~COMP_ACINTEN_IN1;
+    lowerCount = count;
+    isLowerCaptured = true;
+}
+
+// Reads the count Wide Timer 1 latched on the comparator edge, the upper 16 bits come from the prescaler snapshot
+void wideTimer1Isr()
+{
+    uint64_t count = ((uint64_t)(WTIMER1_TAPS_R & 0xFFFF) << 32) | WTIMER1_TAR_R;
+    PROFILE_START(PROBE_CAPTURE_ISR);
+    WTIMER1_ICR_R = TIMER_ICR_CAECINT;
+    WTIMER1_IMR_R &= ~TIMER_IMR_CAEIM;
+    WTIMER1_CTL_R &= ~TIMER_CTL_TAEN;
+    captureMeasurement(count);
+    PROFILE_STOP(PROBE_CAPTURE_ISR);
+}
+
+// Turns off both capture paths, a capture that is already pending is ignored by captureMeasurement()
+void disarmCapture()
+{
+    COMP_ACINTEN_R &= ~(COMP_ACINTEN_IN0 | COMP_ACINTEN_IN1);
+    WTIMER0_CTL_R &= ~TIMER_CTL_TAEN;
+    WTIMER1_IMR_R &= ~TIMER_IMR_CAEIM;
+    WTIMER1_CTL_R &= ~TIMER_CTL_TAEN;
+}
+
+// Clears the capture timer and enables the capture event, call startCaptureTimer() to start counting
+void armCapture()
+{
+    if(isHardwareCapture())
+    {
+        WTIMER1_TAV_R = 0;
+        WTIMER1_ICR_R = TIMER_ICR_CAECINT;
+        WTIMER1_IMR_R |= TIMER_IMR_CAEIM;
+    }
+    else
+    {
+        WTIMER0_TBV_R = 0;
+        WTIMER0_TAV_R = 0;
+        // Drop any edge seen while the interrupt was off, the esr phase of an inductor makes one
+        if(thresholdMode == THRESHOLD_DUAL)
+        {
+            isLowerCaptured = false;
+            COMP_ACMIS_R = COMP_ACMIS_IN1;
+            COMP_ACINTEN_R |= COMP_ACINTEN_IN1;
+        }
+        COMP_ACMIS_R = COMP_ACMIS_IN0;
+        COMP_ACINTEN_R |= COMP_ACINTEN_IN0;
+    }
+}
+
+void startCaptureTimer()
+{
+    if(isHardwareCapture())
+        WTIMER1_CTL_R |= TIMER_CTL_TAEN;
+    else
+        WTIMER0_CTL_R |= TIMER_CTL_TAEN;
+}
+
+// Queues a measurement, returns false if the queue is full
+bool requestMeasurement(MEASUREMENT_TYPE type)
+{
+    uint8_t next = (requestHead + 1) % MEASUREMENT_QUEUE_SIZE;
+    if(next == requestTail)
+        return false;
+    requestQueue[requestHead] = type;
+    requestHead = next;
+    postEvent(EVENT_MEASURE);
+    return true;
+}
+
+bool measureResistance()
+{
+    return requestMeasurement(MEASURE_RESISTANCE);
+}
+
+bool measureCapacitance()
+{
+    return requestMeasurement(MEASURE_CAPACITANCE);
+}
+
+bool measureInductance()
+{
+    return requestMeasurement(MEASURE_INDUCTANCE);
+}
+
+// Drives the pins for the first phase of a measurement
+void startMeasurement(MEASUREMENT_TYPE type)
+{
+    currentType = type;
+    // The inductor runs the esr phase first, the discharge probe starts over when it ends
+    PROFILE_START(PROBE_DISCHARGE);
+    resetMeasurements();
+    // Converts during the discharge, armMeasurement() collects it
+    startTemperatureRead();
+
+    switch(currentType)
+    {
+        case MEASURE_RESISTANCE:
+            // Discharge the 1uF capacitor
+            setPinValue(INTEGRATE, 1);
+            setPinValue(LOWSIDE_R, 1);
+            startDischarge(classifyDischargeTime);
+            state = STATE_DISCHARGE;
+            break;
+        case MEASURE_CAPACITANCE:
+            // Discharge capacitor under test
+            setPinValue(MEAS_C, 1);
+            setPinValue(LOWSIDE_R, 1);
+            startDischarge(classifyDischargeTime);
+            state = STATE_DISCHARGE;
+            break;
+        case MEASURE_INDUCTANCE:
+            // Same part as the last reading, go straight to the discharge
+            if(isEsrCacheValid())
+            {
+                startPhaseTimer(INDUCTOR_DISCHARGE_TIME);
+                state = STATE_DISCHARGE;
+                break;
+            }
+            // The esr is read at DC before the inductor is charged so the ISR has nothing left to do
+            setPinValue(MEAS_LR, 1);
+            setPinValue(LOWSIDE_R, 1);
+            startPhaseTimer(ESR_SETTLE_TIME);
+            state = STATE_ESR;
+            break;
+        case MEASURE_AUTO:
+            // Same discharge as a capacitor, whatever is in the fixture can't hold a charge afterwards
+            classifyPhase = CLASSIFY_LR;
+            setPinValue(MEAS_C, 1);
+            setPinValue(LOWSIDE_R, 1);
+            startDischarge(0);
+            state = STATE_DISCHARGE;
+            break;
+        default:
+            state = STATE_IDLE;
+            break;
+    }
+}
+
+void startNextMeasurement()
+{
+    MEASUREMENT_TYPE type = requestQueue[requestTail];
+    requestTail = (requestTail + 1) % MEASUREMENT_QUEUE_SIZE;
+    isAutoMeasurement = (type == MEASURE_AUTO);
+    classifyDischargeTime = 0;
+    PROFILE_START(PROBE_MEASUREMENT);
+    startMeasurement(type);
+}
+
+// Maps how far a reading is past its decision threshold onto 0..1
+float getConfidence(float margin, float threshold)
+{
+    float confidence = margin / threshold;
+    if(confidence < 0)
+        return 0;
+    if(confidence > 1)
+        return 1;
+    return confidence;
+}
+
+// Sets the discharge after a burst that saw DUT2 decay from start to end, the capacitor
+// discharges through the same 33 Ohm resistor it charged through in the LR burst
+void setClassifyDischarge(float start, float end)
+{
+    uint32_t period = (classifyPhase == CLASSIFY_LR_LONG) ? CLASSIFY_LONG_PERIOD : CLASSIFY_PERIOD;
+    // The quarter averages are three quarters of the burst apart
+    float span = ((CLASSIFY_SAMPLES - CLASSIFY_SAMPLES / 4) * period) / (SYSTEM_CLOCK_HZ / 1e6f);
+    float time = CLASSIFY_DISCHARGE_TAUS * span / logf(start / end);
+
+    if(time > DISCHARGE_TIME)
+        time = DISCHARGE_TIME;
+    classifyDischargeTime = (time > CLASSIFY_DISCHARGE_TIME) ? time : CLASSIFY_DISCHARGE_TIME;
+}
+
+/*
+ * Decides what is in the fixture from the shape of a burst of DUT2 samples
+ *
+ * CLASSIFY_LR: DUT between MEAS_LR and the 33 Ohm low side resistor
+ *   rising   -> inductor (the current builds up)
+ *   decaying -> capacitor (the current dies down)
+ *   flat     -> resistor, unless DUT2 is too close to 0 V to tell a large R from a small C,
+ *               or too close to 3.3 V to tell a small R from a large C (CLASSIFY_LR_LONG)
+ * CLASSIFY_C: DUT between DUT2 and ground (MEAS_C), charged through the high side resistor
+ *   rising   -> capacitor
+ *   flat     -> resistor, unless DUT2 is still near 0 V (CLASSIFY_C_LONG)
+ * The long phases keep the excitation on and sample 100 times slower
+ *
+ * Returns MEASURE_AUTO with classifyPhase set to the next phase if another burst is needed
+ */
+MEASUREMENT_TYPE classifyBurst()
+{
+    float start, end;
+    getDut2BurstTrend(&start, &end);
+    float change = end - start;
+
+    classifyDischargeTime = CLASSIFY_DISCHARGE_TIME;
+    if(classifyPhase == CLASSIFY_LR || classifyPhase == CLASSIFY_LR_LONG)
+    {
+        if(change > CLASSIFY_FLAT_V)
+        {
+            classifyConfidence = getConfidence(change - CLASSIFY_FLAT_V, CLASSIFY_FLAT_V);
+            return MEASURE_INDUCTANCE;
+        }
+        if(change < -CLASSIFY_FLAT_V)
+        {
+            classifyConfidence = getConfidence(-change - CLASSIFY_FLAT_V, CLASSIFY_FLAT_V);
+            setClassifyDischarge(start, end);
+            return MEASURE_CAPACITANCE;
+        }
+        if(end > CLASSIFY_HIGH_V && classifyPhase == CLASSIFY_LR)
+        {
+            classifyPhase = CLASSIFY_LR_LONG;
+            return MEASURE_AUTO;
+        }
+        if(end > CLASSIFY_LEVEL_V)
+        {
+            classifyConfidence = getConfidence(CLASSIFY_FLAT_V - ABS(change), CLASSIFY_FLAT_V);
+            return MEASURE_RESISTANCE;
+        }
+        classifyPhase = CLASSIFY_C;
+        return MEASURE_AUTO;
+    }
+
+    if(change > CLASSIFY_FLAT_V)
+    {
+        classifyConfidence = getConfidence(change - CLASSIFY_FLAT_V, CLASSIFY_FLAT_V);
+        return MEASURE_CAPACITANCE;
+    }
+    if(end < CLASSIFY_LEVEL_V && classifyPhase == CLASSIFY_C)
+    {
+        classifyPhase = CLASSIFY_C_LONG;
+        return MEASURE_AUTO;
+    }
+    classifyConfidence = getConfidence(CLASSIFY_FLAT_V - ABS(change), CLASSIFY_FLAT_V);
+    return MEASURE_RESISTANCE;
+}
+
+// Applies the excitation for the current classification burst and starts sampling
+void startClassifyBurst()
+{
+    bool isLong = (classifyPhase == CLASSIFY_LR_LONG || classifyPhase == CLASSIFY_C_LONG);
+
+    if(classifyPhase == CLASSIFY_LR || classifyPhase == CLASSIFY_LR_LONG)
+    {
+        setPinValue(MEAS_C, 0);
+        setPinValue(LOWSIDE_R, 1);
+        setPinValue(MEAS_LR, 1);
+    }
+    else
+    {
+        setPinValue(LOWSIDE_R, 0);
+        setPinValue(MEAS_C, 1);
+        setPinValue(HIGHSIDE_R, 1);
+    }
+    startDut2Burst(isLong ? CLASSIFY_LONG_PERIOD : CLASSIFY_PERIOD, CLASSIFY_SAMPLES);
+    state = STATE_CLASSIFY;
+}
+
+void finishClassifyBurst()
+{
+    MEASUREMENT_TYPE type = classifyBurst();
+
+    if(type == MEASURE_AUTO)
+    {
+        // The long bursts carry on from where the short one stopped
+        if(classifyPhase == CLASSIFY_LR_LONG || classifyPhase == CLASSIFY_C_LONG)
+        {
+            startClassifyBurst();
+            return;
+        }
+        // Flat near 0 V, discharge and try again with the DUT across DUT2 and ground
+        PROFILE_START(PROBE_DISCHARGE);
+        resetMeasurements();
+        setPinValue(MEAS_C, 1);
+        setPinValue(LOWSIDE_R, 1);
+        startDischarge(classifyDischargeTime);
+        state = STATE_DISCHARGE;
+        return;
+    }
+
+    // The real measurement starts with its own discharge, long enough for what the burst left on the part
+    startMeasurement(type);
+}
+
+uint32_t getChargeProbeTime(MEASUREMENT_TYPE type)
+{
+    return (type == MEASURE_CAPACITANCE) ? CAPACITANCE_PROBE_TIME : CHARGE_PROBE_TIME;
+}
+
+uint32_t getChargeTimeout(MEASUREMENT_TYPE type)
+{
+    switch(type)
+    {
+        case MEASURE_RESISTANCE:
+            return RESISTANCE_TIMEOUT;
+        case MEASURE_CAPACITANCE:
+            return CAPACITANCE_TIMEOUT;
+        default:
+            return INDUCTANCE_TIMEOUT;
+    }
+}
+
+// Runs the phase timer for the next part of the charge timeout, returns false once it is used up
+bool continueChargeTimeout()
+{
+    uint32_t us = (chargeTimeLeft > PHASE_TIMER_MAX_TIME) ? PHASE_TIMER_MAX_TIME : chargeTimeLeft;
+    if(us == 0)
+        return false;
+    chargeTimeLeft -= us;
+    startPhaseTimer(us);
+    return true;
+}
+
+// Called each time the phase timer runs out while charging, first at the probe time, then at the timeout
+void checkChargeTimeout()
+{
+    MEASUREMENT_STATUS status = RESULT_OVER_RANGE;
+
+    if(!isChargeProbed)
+    {
+        // Still on the level it started from: an open for R and L, a short across the C input
+        if(readDut2Raw() >= chargeStartRaw + (CHARGE_PROBE_MV * 4096) / (VSUPPLY * 1000))
+        {
+            isChargeProbed = true;
+            chargeTimeLeft = getChargeTimeout(currentType) - getChargeProbeTime(currentType);
+            continueChargeTimeout();
+            return;
+        }
+        status = (currentType == MEASURE_CAPACITANCE) ? RESULT_SHORT : RESULT_OPEN;
+    }
+    else if(continueChargeTimeout())
+        return;
+
+    // Ends the charge the same way a capture does, so the pins are left discharging the DUT
+    // An edge taken just before this already ended the charge and captureMeasurement() does nothing
+    disableInterrupts();
+    disarmCapture();
+    captureStatus = status;
+    captureMeasurement(0);
+    enableInterrupts();
+}
+
+// Reset the timer, enable the capture event and start charging the DUT
+void armMeasurement()
+{
+    if(currentType != MEASURE_AUTO)
+    {
+        finishTemperatureRead();
+        chargeStartRaw = readDut2Raw();
+        isChargeProbed = false;
+        captureStatus = RESULT_OK;
+        startPhaseTimer(getChargeProbeTime(currentType));
+    }
+
+    // The ISR ignores the comparator unless we are charging
+    state = STATE_CHARGE;
+
+    switch(currentType)
+    {
+        case MEASURE_RESISTANCE:
+            // Turn of low side r
+            setPinValue(LOWSIDE_R, 0);
+            armCapture();
+            // Count from before the drive, a shorted DUT trips the comparator at once
+            startCaptureTimer();
+            setPinValue(MEAS_LR, 1);
+            break;
+        case MEASURE_CAPACITANCE:
+            setPinValue(LOWSIDE_R, 0);
+            armCapture();
+            isFitCapture = false;
+            startCaptureTimer();
+            setPinValue(HIGHSIDE_R, 1);
+            if(isCapacitanceFitEnabled)
+                startChargeFit();
+            break;
+        case MEASURE_INDUCTANCE:
+            setPinValue(LOWSIDE_R, 1);
+            armCapture();
+            startCaptureTimer();
+            setPinValue(MEAS_LR, 1);
+            break;
+        case MEASURE_AUTO:
+            startClassifyBurst();
+            break;
+        default:
+            state = STATE_IDLE;
+            break;
+    }
+}
+
+/*
+ * Scales a count between the two thresholds to the count of a charge from 0 V to COMPARATOR_VREF,
+ * so the calibration constants work for both modes
+ * DUT2 charges exponentially towards vFinal, the time from v1 to v2 is tau * ln((vFinal - v1) / (vFinal - v2))
+ */
+double getDualThresholdScale(double vFinal)
+{
+    return log(VSUPPLY / (VSUPPLY - COMPARATOR_VREF)) / log((vFinal - COMPARATOR1_VREF) / (vFinal - DUAL_UPPER_VREF));
+}
+
+// TEMP = 147.5 - (75 * VREFP * ADCCODE) / 4096, from the datasheet
+float convertTemperature(uint16_t raw)
+{
+    return 147.5f - (75 * VSUPPLY * raw) / 4096;
+}
+
+// Temperature of the last measurement in degrees C
+float getTemperature()
+{
+    return convertTemperature(temperatureRaw);
+}
+
+void setTemperatureCompensation(bool enabled)
+{
+    isTemperatureCompensated = enabled;
+}
+
+bool getTemperatureCompensation()
+{
+    return isTemperatureCompensated;
+}
+
+void setTemperatureCoefficient(MEASUREMENT_TYPE type, int16_t ppm)
+{
+    if(type < MEASURE_AUTO)
+        temperatureCoefficients[type] = ppm;
+}
+
+int16_t getTemperatureCoefficient(MEASUREMENT_TYPE type)
+{
+    return (type < MEASURE_AUTO) ? temperatureCoefficients[type] : 0;
+}
+
+// The count less the residual of the fixture, never below 0
+uint64_t removeZeroOffset(MEASUREMENT_TYPE type, uint64_t count)
+{
+    return (count > zeroOffsets[type]) ? count - zeroOffsets[type] : 0;
+}
+
+// True if the raw count is that of the empty fixture, a short across the R input or nothing across the C input
+bool isEmptyFixtureCount(MEASUREMENT_TYPE type, uint64_t count)
+{
+    if(!isZeroed[type])
+        return count <= EMPTY_FIXTURE_COUNTS;
+    return count <= zeroOffsets[type] + ZERO_NOISE_COUNTS;
+}
+
+// Converts a raw capture record into the value of the DUT
+// result->count stays the raw count, the value has the zero offset taken off
+// A curve fit has no timer count, its result carries the count the comparator would have seen
+void convertCaptureRecord(CAPTURE_RECORD* record, MEASUREMENT_RESULT* out)
+{
+    uint64_t count = removeZeroOffset(record->type, record->count);
+
+    out->type = record->type;
+    out->status = record->status;
+    out->count = record->count;
+    if(record->isFit)
+        out->count = record->fitTau * log(VSUPPLY / (VSUPPLY - COMPARATOR_VREF)) + 0.5;
+    out->value = 0;
+    out->esr = 0;
+    out->temperature = convertTemperature(record->temperatureRaw);
+    out->time = record->time;
+    out->isAuto = record->isAuto;
+    out->confidence = record->isAuto ? record->confidence : 1;
+
+    if(out->status != RESULT_OK)
+        return;
+
+    switch(record->type)
+    {
+        case MEASURE_RESISTANCE:
+            if(isEmptyFixtureCount(MEASURE_RESISTANCE, out->count))
+            {
+                out->status = RESULT_SHORT;
+                return;
+            }
+            out->value = count / RESISTANCE_CONST;
+            if(record->isDual)
+                out->value *= getDualThresholdScale(VSUPPLY);
+            break;
+        case MEASURE_CAPACITANCE:
+            if(isEmptyFixtureCount(MEASURE_CAPACITANCE, out->count))
+            {
+                out->status = RESULT_OPEN;
+                return;
+            }
+            // Scale tau to the count the comparator would have seen, so both paths share the calibration
+            if(record->isFit)
+                out->value = (record->fitTau * log(VSUPPLY / (VSUPPLY - COMPARATOR_VREF)) - zeroOffsets[MEASURE_CAPACITANCE]) / CAPACITANCE_CONST;
+            else if(record->isDual)
+                out->value = (count * getDualThresholdScale(VSUPPLY)) / CAPACITANCE_CONST;
+            else
+                out->value = count / CAPACITANCE_CONST;
+            break;
+        case MEASURE_INDUCTANCE:
+            out->esr = calculateEsr(record->esrQ3Vc, record->esrQ7Vc, record->esrDut2);
+            if(record->isDual)
+            {
+                // The current settles where the esr phase read DUT2, the time constant is L / (33 Ohm + esr)
+                float dut2 = (VSUPPLY * (record->esrDut2 + 0.5)) / 4096.0;
+                if(dut2 <= DUAL_UPPER_VREF)
+                    out->status = RESULT_OVER_RANGE;
+                else
+                    out->value = (count * getDualThresholdScale(dut2) * ((R33OHMS + out->esr) / R33OHMS)) / INDUCTANCE_CONST;
+            }
+            else
+                out->value = (count * (R33OHMS / (R33OHMS + out->esr))) / INDUCTANCE_CONST;
+            break;
+        default:
+            break;
+    }
+
+    // Take out the drift of the board since calibration
+    if(isTemperatureCompensated && out->type < MEASURE_AUTO)
+        out->value /= 1 + temperatureCoefficients[out->type] * 1e-6f * (out->temperature - CALIBRATION_TEMP_C);
+}
+
+// Advances the measurement by at most one phase, call this from the main loop
+void stepMeasurement()
+{
+    switch(state)
+    {
+        case STATE_IDLE:
+            if(requestHead != requestTail)
+                startNextMeasurement();
+            break;
+        case STATE_ESR:
+            if(isPhaseTimerExpired())
+            {
+                PROFILE_START(PROBE_ESR_READ);
+                readEsrInputs(&esrQ3Vc, &esrQ7Vc, &esrDut2);
+                PROFILE_STOP(PROBE_ESR_READ);
+                isEsrCached = true;
+                esrCachedReadings = 0;
+                // Let the inductor current die down before the timed charge
+                setPinValue(MEAS_LR, 0);
+                setPinValue(LOWSIDE_R, 0);
+                startPhaseTimer(INDUCTOR_DISCHARGE_TIME);
+                PROFILE_START(PROBE_DISCHARGE);
+                state = STATE_DISCHARGE;
+            }
+            break;
+        case STATE_DISCHARGE:
+            // The inductor current is not visible on DUT2, so it always gets the fixed time
+            if(currentType == MEASURE_INDUCTANCE ? isPhaseTimerExpired() : isDischargeDone())
+            {
+                PROFILE_STOP(PROBE_DISCHARGE);
+                state = STATE_ARM;
+            }
+            break;
+        case STATE_ARM:
+            PROFILE_START(PROBE_ARM);
+            armMeasurement();
+            PROFILE_STOP(PROBE_ARM);
+            break;
+        case STATE_CHARGE:
+            // Waiting on comparator0Isr() or wideTimer1Isr(), or on enough of the charge curve
+            if(isPhaseTimerExpired())
+                checkChargeTimeout();
+            else if(currentType == MEASURE_CAPACITANCE && isCapacitanceFitEnabled && isChargeFitReady())
+            {
+                // Without a usable fit, stop sampling and let the comparator finish the job
+                // There is no timer count for a fit, the record carries fitTau instead
+                if(getChargeFitTau(&fitTau))
+                {
+                    disableInterrupts();
+                    disarmCapture();
+                    isFitCapture = true;
+                    captureMeasurement(0);
+                    enableInterrupts();
+                }
+                else
+                    stopChargeFit();
+            }
+            break;
+        case STATE_CLASSIFY:
+            if(isDut2BurstDone())
+                finishClassifyBurst();
+            break;
+        case STATE_CAPTURE:
+            if(isEsrRetry)
+            {
+                isEsrRetry = false;
+                startMeasurement(MEASURE_INDUCTANCE);
+                break;
+            }
+            // The record is already queued, pick up the next request
+            if(currentType == MEASURE_CAPACITANCE)
+                stopChargeFit();
+            currentType = MEASURE_NONE;
+            state = STATE_IDLE;
+            break;
+    }
+}
+
+void setCapacitanceFit(bool enabled)
+{
+    isCapacitanceFitEnabled = enabled;
+}
+
+bool getCapacitanceFit()
+{
+    return isCapacitanceFitEnabled;
+}
+
+bool measureAuto()
+{
+    return requestMeasurement(MEASURE_AUTO);
+}
+
+// True once every request has been measured and every result has been collected
+bool isMeasurementIdle()
+{
+    return (state == STATE_IDLE) && (requestHead == requestTail) && (captureHead == captureTail);
+}
+
+// True if stepMeasurement() has something to do now rather than on the phase timer or a capture
+bool isMeasurementStepDue()
+{
+    switch(state)
+    {
+        case STATE_IDLE:
+            return requestHead != requestTail;
+        case STATE_ARM:
+        case STATE_CAPTURE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// True while a request is queued that the engine has not started on yet
+bool isMeasurementRequestPending()
+{
+    return requestHead != requestTail;
+}
+
+// Converts and removes the oldest queued capture without keeping it in the history
+bool takeMeasurementResult(MEASUREMENT_RESULT* out)
+{
+    if(captureTail == captureHead)
+        return false;
+    PROFILE_START(PROBE_CONVERT);
+    convertCaptureRecord(&captureQueue[captureTail], out);
+    PROFILE_STOP(PROBE_CONVERT);
+    captureTail = (captureTail + 1) & (CAPTURE_QUEUE_SIZE - 1);
+    return true;
+}
+
+// Converts the oldest queued capture and keeps it in the history, returns false if there is nothing new
+bool getMeasurementResult(MEASUREMENT_RESULT* out)
+{
+    if(!takeMeasurementResult(out))
+        return false;
+    addHistory(out);
+    return true;
+}
+
+/*
+ * Starts measuring the empty fixture ZERO_READINGS times, the average raw count becomes the offset of the type
+ * The fixture has to be open for capacitance and shorted for resistance and inductance,
+ * and nothing else may be queued
+ * Every result goes to addZeroReading() (take it with takeMeasurementResult(), the history never sees it)
+ */
+bool startZero(MEASUREMENT_TYPE type)
+{
+    if(type != MEASURE_RESISTANCE && type != MEASURE_CAPACITANCE && type != MEASURE_INDUCTANCE)
+        return false;
+
+    zeroOffsets[type] = 0;
+    isZeroed[type] = false;
+    zeroType = type;
+    zeroReadings = 0;
+    zeroSum = 0;
+    isZeroEmpty = true;
+    return requestMeasurement(type);
+}
+
+// Adds one reading to the zero and queues the next, returns false once the zero is over
+// isZeroValid() then tells if it took, the offset stays at 0 if a part seems to be in the fixture
+// A part ends the zero at once, the rest of the readings could only take as long as its charge timeout
+bool addZeroReading(MEASUREMENT_RESULT* result)
+{
+    if(zeroType == MEASURE_NONE)
+        return false;
+
+    // An open or shorted fixture reads below the range of the type, its leads may take it past the empty band
+    if(zeroType == MEASURE_INDUCTANCE)
+        isZeroEmpty &= (result->status == RESULT_OK) && (result->value < ZERO_INDUCTANCE_MAX_UH);
+    else
+        isZeroEmpty &= (result->status == RESULT_OK || result->status == ((zeroType == MEASURE_CAPACITANCE) ? RESULT_OPEN : RESULT_SHORT))
+                       && (result->count <= ZERO_MAX_COUNTS);
+    zeroSum += result->count;
+
+    if(++zeroReadings < ZERO_READINGS && isZeroEmpty)
+        return requestMeasurement(zeroType);
+
+    if(isZeroEmpty)
+    {
+        zeroOffsets[zeroType] = (zeroSum + ZERO_READINGS / 2) / ZERO_READINGS;
+        isZeroed[zeroType] = true;
+    }
+    zeroType = MEASURE_NONE;
+    return false;
+}
+
+bool isZeroValid(MEASUREMENT_TYPE type)
+{
+    return (type < MEASURE_AUTO) ? isZeroed[type] : false;
+}
+
+void clearZeroOffsets()
+{
+    uint8_t i;
+    for(i = 0; i < MEASURE_AUTO; i++)
+    {
+        zeroOffsets[i] = 0;
+        isZeroed[i] = false;
+    }
+}
+
+uint32_t getZeroOffset(MEASUREMENT_TYPE type)
+{
+    return (type < MEASURE_AUTO) ? zeroOffsets[type] : 0;
+}
+
+// Number of captures lost because the main loop did not keep up
+uint16_t getDroppedCaptures()
+{
+    return droppedCaptures;
+}
@@ -0,0 +1,277 @@
+// Measurement Library
+// Sarker Nadir Afridi Azmi
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Hardware configuration:
+// Analog Comparator 0 (C0- on PC7) watching DUT2
+// Analog Comparator 1 (C1- on PC4) jumpered to DUT2, C1+ (PC5) on a 10k/3.3k divider from 3.3V
+// Wide Timer 0 (64-bit) measures the charge time, Timer 1 times the discharge/settle phases
+// Hardware capture: C0o (PF0) jumpered to WT1CCP0 (PC6), Wide Timer 1A in edge time mode (48-bit)
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef MEASURE_H_
+#define MEASURE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "gpio.h"
+
+#define INTEGRATE               PORTA,6
+#define MEAS_LR                 PORTA,7
+#define LOWSIDE_R               PORTB,5
+#define HIGHSIDE_R              PORTB,6
+#define MEAS_C                  PORTB,7
+
+#define ANALOG_COMPARATOR0      PORTC,7
+#define ANALOG_COMPARATOR1      PORTC,4
+#define COMPARATOR1_REFERENCE   PORTC,5
+#define COMPARATOR0_OUTPUT      PORTF,0
+#define COMPARATOR0_CAPTURE     PORTC,6
+
+// PortE masks
+#define AIN3                    PORTE,0
+#define AIN2                    PORTE,1
+#define AIN1                    PORTE,2
+
+// Fixed discharge time, also the safety timeout of an adaptive discharge
+#define DISCHARGE_TIME          1000000
+#define DISCHARGE_THRESHOLD_MV  5
+// An adaptive discharge goes on for this share of the time it took to reach the threshold, which leaves
+// threshold x sqrt(threshold / starting voltage) on DUT2, 0.2 mV from 2.469 V, under one ADC count
+#define DISCHARGE_SETTLE_PERCENT 50
+// How often an adaptive discharge checks DUT2, the phase timer wakes the core for each check
+#define DISCHARGE_POLL_TIME     50
+#define ESR_SETTLE_TIME         1000
+#define INDUCTOR_DISCHARGE_TIME 1000
+#define RESISTANCE_CONST        57.90883367
+#define CAPACITANCE_CONST       5194551.85
+#define INDUCTANCE_CONST        1.5303
+#define VSUPPLY                 3.295
+#define COMPARATOR_VREF         2.469
+// Dual threshold timing: COMP1 trips at the divider voltage, COMP0 at a lower ladder tap than COMPARATOR_VREF
+#define COMPARATOR1_VREF        0.818
+#define DUAL_UPPER_VREF         1.657
+#define DUAL_UPPER_TAP          8
+#define R33OHMS                 32.7
+// The esr inputs and the internal temperature sensor share one SS1 sequence
+#define ESR_SAMPLE_COUNT        4
+
+// Temperature compensation, the drift of a reading in ppm per degree C away from CALIBRATION_TEMP_C
+// Worked out for the board by reading a reference part at two temperatures, 0 until then
+#define CALIBRATION_TEMP_C      25
+#define RESISTANCE_TEMPCO_PPM   0
+#define CAPACITANCE_TEMPCO_PPM  0
+#define INDUCTANCE_TEMPCO_PPM   0
+
+// Bounds on the charge phase, the comparator never fires if nothing is in the fixture or the part is too big
+// DUT2 has to rise CHARGE_PROBE_MV by the probe time, the timeouts are the full scale of each range
+// A capacitor gets longer to rise so a large one is not taken for a short
+#define CHARGE_PROBE_MV         5
+#define CHARGE_PROBE_TIME       50000
+#define CAPACITANCE_PROBE_TIME  2000000
+#define RESISTANCE_TIMEOUT      3000000
+#define CAPACITANCE_TIMEOUT     300000000
+#define INDUCTANCE_TIMEOUT      100000
+// Longest single run of the 32-bit phase timer (Timer 1)
+#define PHASE_TIMER_MAX_TIME    100000000
+// A short across the R input or nothing across the C input charges within the capture latency,
+// so the raw count decides it, not the value: until the fixture is zeroed a count up to EMPTY_FIXTURE_COUNTS
+// (17 counts of software capture latency, plus 0.12 Ohm or 1.3 pF), after that the zero offset give or take
+// ZERO_NOISE_COUNTS, which leaves every part above the noise to be read
+#define EMPTY_FIXTURE_COUNTS    24
+#define ZERO_NOISE_COUNTS       4
+
+// Inductance readings reuse the esr of the part in the fixture, it is read again when the part changes
+// or every ESR_REFRESH_READINGS readings (0 = only when the part changes)
+// A charge count more than ESR_CHANGE_PERCENT away from the first one on a cached esr is a new part
+#define ESR_REFRESH_READINGS    0
+#define ESR_CHANGE_PERCENT      10
+
+// Fixture zeroing, the residual count of ZERO_READINGS readings is averaged
+// A count above ZERO_MAX_COUNTS (2 Ohm, 22 pF) or an inductance above ZERO_INDUCTANCE_MAX_UH is a part
+// left in the fixture, not a short or an open
+#define ZERO_READINGS           8
+#define ZERO_MAX_COUNTS         116
+#define ZERO_INDUCTANCE_MAX_UH  50
+
+// Number of measurements that can be queued while one is in progress
+#define MEASUREMENT_QUEUE_SIZE  4
+// Number of raw captures waiting to be converted, must be a power of 2
+#define CAPTURE_QUEUE_SIZE      8
+
+// Auto classification, a burst of 32 DUT2 samples 5 us apart
+// A flat burst that can still be a slow capacitor is taken again with the samples 500 us apart,
+// a capacitor above 400 uF hardly moves in 160 us
+#define CLASSIFY_SAMPLES        32
+#define CLASSIFY_PERIOD         200
+#define CLASSIFY_LONG_PERIOD    20000
+#define CLASSIFY_FLAT_V         0.03
+#define CLASSIFY_LEVEL_V        0.05
+#define CLASSIFY_HIGH_V         3.0
+// A capacitor comes out of the LR burst charged the other way, which the ADC reads as 0 V
+// The discharge after a burst lasts CLASSIFY_DISCHARGE_TAUS of the time constant the burst saw,
+// and at least CLASSIFY_DISCHARGE_TIME (us)
+#define CLASSIFY_DISCHARGE_TIME 1000
+#define CLASSIFY_DISCHARGE_TAUS 10
+
+//-----------------------------------------------------------------------------
+// Structs
+//-----------------------------------------------------------------------------
+
+typedef enum _MEASUREMENT_TYPE
+{
+    MEASURE_NONE,
+    MEASURE_RESISTANCE,
+    MEASURE_CAPACITANCE,
+    MEASURE_INDUCTANCE,
+    MEASURE_AUTO
+} MEASUREMENT_TYPE;
+
+/*
+ * Phases of a single measurement
+ * IDLE -> (ESR) -> DISCHARGE -> ARM -> CHARGE -> CAPTURE -> IDLE
+ * CHARGE -> CAPTURE is the only transition made by an interrupt (comparator0Isr)
+ * CHARGE also ends in CAPTURE when DUT2 fails the probe or the charge times out, the record then carries the status
+ * The phase timer (timer1Isr), the captures and the fit or burst sampling post EVENT_MEASURE for the next step
+ * The capture is queued as a raw CAPTURE_RECORD and reported later by getMeasurementResult()
+ * An auto measurement goes DISCHARGE -> ARM -> CLASSIFY (up to four bursts) before the real measurement starts
+ */
+typedef enum _MEASUREMENT_STATE
+{
+    STATE_IDLE,
+    STATE_ESR,
+    STATE_DISCHARGE,
+    STATE_ARM,
+    STATE_CLASSIFY,
+    STATE_CHARGE,
+    STATE_CAPTURE
+} MEASUREMENT_STATE;
+
+// SOFTWARE reads Timer 0 in comparator0Isr(), HARDWARE lets Wide Timer 1 latch the comparator edge
+typedef enum _CAPTURE_MODE
+{
+    CAPTURE_SOFTWARE,
+    CAPTURE_HARDWARE
+} CAPTURE_MODE;
+
+// SINGLE times 0 V to COMPARATOR_VREF on COMP0
+// DUAL times COMPARATOR1_VREF (COMP1) to DUAL_UPPER_VREF (COMP0), which takes out the starting voltage,
+// the comparator offset and the interrupt latency, and stops the charge sooner
+typedef enum _THRESHOLD_MODE
+{
+    THRESHOLD_SINGLE,
+    THRESHOLD_DUAL
+} THRESHOLD_MODE;
+
+// FIXED always waits DISCHARGE_TIME, ADAPTIVE stops once DUT2 has settled below the threshold
+typedef enum _DISCHARGE_MODE
+{
+    DISCHARGE_FIXED,
+    DISCHARGE_ADAPTIVE
+} DISCHARGE_MODE;
+
+// A result that is not OK carries no value
+typedef enum _MEASUREMENT_STATUS
+{
+    RESULT_OK,
+    RESULT_OPEN,
+    RESULT_SHORT,
+    RESULT_OVER_RANGE
+} MEASUREMENT_STATUS;
+
+// Everything needed to work out a result later, kept small so the ISR can copy it quickly
+typedef struct _CAPTURE_RECORD
+{
+    MEASUREMENT_TYPE type;
+    MEASUREMENT_STATUS status;
+    uint64_t count;
+    uint16_t esrQ3Vc;
+    uint16_t esrQ7Vc;
+    uint16_t esrDut2;
+    uint16_t temperatureRaw;
+    uint32_t time;
+    bool isAuto;
+    bool isFit;
+    bool isDual;
+    float confidence;
+    float fitTau;
+} CAPTURE_RECORD;
+
+typedef struct _MEASUREMENT_RESULT
+{
+    MEASUREMENT_TYPE type;
+    MEASUREMENT_STATUS status;
+    uint64_t count;
+    float value;
+    float esr;
+    float temperature;
+    uint32_t time;
+    bool isAuto;
+    float confidence;
+} MEASUREMENT_RESULT;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initLcrMeter();
+void initTimer();
+void initComparator0();
+void initComparator1();
+void resetMeasurements();
+void setCaptureMode(CAPTURE_MODE mode);
+CAPTURE_MODE getCaptureMode();
+void setThresholdMode(THRESHOLD_MODE mode);
+THRESHOLD_MODE getThresholdMode();
+
+void setDischargeMode(DISCHARGE_MODE mode, uint16_t thresholdMv);
+DISCHARGE_MODE getDischargeMode();
+uint16_t getDischargeThreshold();
+void initEsrSequence();
+float readDutResistance();
+float measureEsr();
+void setEsrCache(bool enabled, uint16_t refreshReadings);
+bool getEsrCache();
+uint16_t getEsrRefresh();
+void clearEsrCache();
+
+bool requestMeasurement(MEASUREMENT_TYPE type);
+bool measureResistance();
+bool measureCapacitance();
+bool measureInductance();
+bool measureAuto();
+
+float getTemperature();
+void setTemperatureCompensation(bool enabled);
+bool getTemperatureCompensation();
+void setTemperatureCoefficient(MEASUREMENT_TYPE type, int16_t ppm);
+int16_t getTemperatureCoefficient(MEASUREMENT_TYPE type);
+
+bool startZero(MEASUREMENT_TYPE type);
+bool addZeroReading(MEASUREMENT_RESULT* result);
+bool isZeroValid(MEASUREMENT_TYPE type);
+void clearZeroOffsets();
+uint32_t getZeroOffset(MEASUREMENT_TYPE type);
+
+void setCapacitanceFit(bool enabled);
+bool getCapacitanceFit();
+
+void stepMeasurement();
+bool isMeasurementStepDue();
+bool isMeasurementIdle();
+bool isMeasurementRequestPending();
+bool getMeasurementResult(MEASUREMENT_RESULT* result);
+bool takeMeasurementResult(MEASUREMENT_RESULT* out);
+uint16_t getDroppedCaptures();
+
+#endif
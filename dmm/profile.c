@@ -0,0 +1,85 @@
+// Profiler Library
+// Sarker Nadir Afridi Azmi
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Hardware configuration:
+// DWT cycle counter (CYCCNT) of the Cortex-M4
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tm4c123gh6pm.h"
+#include "profile.h"
+
+#ifdef PROFILE
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+uint32_t probeStarts[PROBE_COUNT];
+PROBE_STATS probeStats[PROBE_COUNT];
+
+const char* probeNames[PROBE_COUNT] =
+{
+    "measurement", "discharge", "esr read", "arm", "capture isr", "convert", "format", "uart tx"
+};
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initProfiler()
+{
+    NVIC_DBG_INT_R |= DEMCR_TRCENA;                  // turn on the DWT
+    DWT_CYCCNT_R = 0;
+    DWT_CTRL_R |= DWT_CTRL_CYCCNTENA;                // start the cycle counter
+    clearProfile();
+}
+
+// Adds the cycles since PROFILE_START() of the same probe, the subtraction is right across a wrap
+void stopProbe(PROFILE_PROBE probe)
+{
+    uint32_t cycles = DWT_CYCCNT_R - probeStarts[probe];
+    PROBE_STATS* stats = &probeStats[probe];
+    if(stats->count == 0 || cycles < stats->min)
+        stats->min = cycles;
+    if(cycles > stats->max)
+        stats->max = cycles;
+    stats->total += cycles;
+    stats->count++;
+}
+
+void clearProfile()
+{
+    uint8_t i;
+    for(i = 0; i < PROBE_COUNT; i++)
+    {
+        probeStats[i].count = 0;
+        probeStats[i].min = 0;
+        probeStats[i].max = 0;
+        probeStats[i].total = 0;
+    }
+}
+
+void getProbeStats(PROFILE_PROBE probe, PROBE_STATS* stats)
+{
+    *stats = probeStats[probe];
+}
+
+const char* getProbeName(PROFILE_PROBE probe)
+{
+    return probeNames[probe];
+}
+
+#endif
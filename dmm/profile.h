@@ -0,0 +1,87 @@
+// Profiler Library
+// Sarker Nadir Afridi Azmi
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Hardware configuration:
+// DWT cycle counter (CYCCNT) of the Cortex-M4
+// Build with PROFILE defined to get the probes, without it PROFILE_START() and PROFILE_STOP()
+// are empty and nothing of this library is compiled
+// A probe wraps after 2^32 cycles (107 s), so the charge of a large capacitor reads short
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Not in tm4c123gh6pm.h, DEMCR is NVIC_DBG_INT_R there
+#ifndef DWT_CTRL_R
+#define DWT_CTRL_R              (*((volatile uint32_t *)0xE0001000))
+#endif
+#ifndef DWT_CYCCNT_R
+#define DWT_CYCCNT_R            (*((volatile uint32_t *)0xE0001004))
+#endif
+#define DWT_CTRL_CYCCNTENA      0x00000001
+#define DEMCR_TRCENA            0x01000000
+
+//-----------------------------------------------------------------------------
+// Structs
+//-----------------------------------------------------------------------------
+
+typedef enum _PROFILE_PROBE
+{
+    PROBE_MEASUREMENT,          // first pin change to the capture
+    PROBE_DISCHARGE,
+    PROBE_ESR_READ,
+    PROBE_ARM,
+    PROBE_CAPTURE_ISR,
+    PROBE_CONVERT,
+    PROBE_FORMAT,
+    PROBE_UART_TX,              // queueing a result line
+    PROBE_COUNT
+} PROFILE_PROBE;
+
+typedef struct _PROBE_STATS
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+} PROBE_STATS;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+#ifdef PROFILE
+
+extern uint32_t probeStarts[PROBE_COUNT];
+
+#define PROFILE_START(probe)    (probeStarts[probe] = DWT_CYCCNT_R)
+#define PROFILE_STOP(probe)     stopProbe(probe)
+
+void initProfiler();
+void stopProbe(PROFILE_PROBE probe);
+void clearProfile();
+void getProbeStats(PROFILE_PROBE probe, PROBE_STATS* stats);
+const char* getProbeName(PROFILE_PROBE probe);
+
+#else
+
+#define PROFILE_START(probe)
+#define PROFILE_STOP(probe)
+
+#endif
+
+#endif
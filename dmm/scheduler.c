@@ -0,0 +1,140 @@
+// Scheduler Library
+// Sarker Nadir Afridi Azmi
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Hardware configuration:
+// SysTick (wait.c), the time base of the timed tasks and what wakes the core
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tm4c123gh6pm.h"
+#include "wait.h"
+#include "scheduler.h"
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+TASK tasks[MAX_TASKS];
+uint8_t taskCount = 0;
+
+// One flag per event rather than a mask, so an ISR can post without a read-modify-write
+volatile bool eventFlags[EVENT_COUNT];
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// The task runs to completion on every pass that has one of its events pending
+bool addTask(TASK_FUNCTION function, uint32_t eventMask)
+{
+    if(taskCount == MAX_TASKS)
+        return false;
+    tasks[taskCount].function = function;
+    tasks[taskCount].eventMask = eventMask;
+    tasks[taskCount].period = 0;
+    taskCount++;
+    return true;
+}
+
+// The task runs every period ms and on any of its events, a late run does not make the next one come sooner
+bool addTimedTask(TASK_FUNCTION function, uint32_t period, uint32_t eventMask)
+{
+    if(taskCount == MAX_TASKS || period == 0)
+        return false;
+    tasks[taskCount].function = function;
+    tasks[taskCount].eventMask = eventMask;
+    tasks[taskCount].period = period;
+    tasks[taskCount].next = getMilliseconds() + period;
+    taskCount++;
+    return true;
+}
+
+// Safe from ISRs
+void postEvent(EVENT event)
+{
+    eventFlags[event] = true;
+}
+
+// Runs every task that is due once, returns false if nothing was
+// An event posted while a task runs is kept for the next pass
+bool runReadyTasks()
+{
+    uint32_t pending = 0;
+    uint32_t now = getMilliseconds();
+    bool isAnyRun = false;
+    uint8_t i;
+
+    // Take the flags before running anything
+    for(i = 0; i < EVENT_COUNT; i++)
+    {
+        if(eventFlags[i])
+        {
+            eventFlags[i] = false;
+            pending |= EVENT_MASK(i);
+        }
+    }
+
+    for(i = 0; i < taskCount; i++)
+    {
+        TASK* task = &tasks[i];
+        bool isDue = (task->eventMask & pending) != 0;
+        if(task->period != 0 && (int32_t)(now - task->next) >= 0)
+        {
+            task->next = now + task->period;
+            isDue = true;
+        }
+        if(isDue)
+        {
+            task->function();
+            isAnyRun = true;
+        }
+    }
+    return isAnyRun;
+}
+
+// True if an event is pending or a timed task is due
+bool isAnyTaskReady()
+{
+    uint32_t now = getMilliseconds();
+    uint8_t i;
+
+    for(i = 0; i < EVENT_COUNT; i++)
+    {
+        if(eventFlags[i])
+            return true;
+    }
+    for(i = 0; i < taskCount; i++)
+    {
+        if(tasks[i].period != 0 && (int32_t)(now - tasks[i].next) >= 0)
+            return true;
+    }
+    return false;
+}
+
+// Never returns, the core sleeps until the next interrupt whenever a pass has nothing to run
+// The check and the sleep run with interrupts masked, so an event posted after the pass can't be
+// missed: its interrupt stays pending, which still wakes WFI, and runs once they are enabled again
+void runScheduler()
+{
+    while(true)
+    {
+        if(runReadyTasks())
+            continue;
+        disableInterrupts();
+        if(!isAnyTaskReady())
+            waitForInterrupt();
+        enableInterrupts();
+    }
+}
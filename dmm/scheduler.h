@@ -0,0 +1,65 @@
+// Scheduler Library
+// Sarker Nadir Afridi Azmi
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Hardware configuration:
+// SysTick (wait.c), the time base of the timed tasks and what wakes the core
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MAX_TASKS               8
+
+//-----------------------------------------------------------------------------
+// Structs
+//-----------------------------------------------------------------------------
+
+// Posted from tasks or ISRs, a task runs once for any number of posts since it last ran
+typedef enum _EVENT
+{
+    EVENT_MEASURE,              // a measurement was requested or has a step due
+    EVENT_RESULT,               // a capture is queued (posted from the capture ISRs)
+    EVENT_LINE_READY,           // a command line came in on UART0
+    EVENT_STREAM,               // the stream has something to do
+    EVENT_SORT,                 // the sort has something to do
+    EVENT_COMMAND_DONE,         // the terminal is done with the last line
+    EVENT_COUNT
+} EVENT;
+
+#define EVENT_MASK(event)       (1 << (event))
+
+typedef void (*TASK_FUNCTION)();
+
+typedef struct _TASK
+{
+    TASK_FUNCTION function;
+    uint32_t eventMask;
+    uint32_t period;            // ms, 0 if the task is not timed
+    uint32_t next;              // ms
+} TASK;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+bool addTask(TASK_FUNCTION function, uint32_t eventMask);
+bool addTimedTask(TASK_FUNCTION function, uint32_t period, uint32_t eventMask);
+void postEvent(EVENT event);
+bool runReadyTasks();
+void runScheduler();
+
+#endif
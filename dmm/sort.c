@@ -0,0 +1,165 @@
+// Sorting Library
+// Sarker Nadir Afridi Azmi
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Hardware configuration:
+// Part present strobe on PF4, active low (SW1 on the LaunchPad)
+// Results on PF1 (FAIL), PF2 (BIN) and PF3 (PASS), the RGB LED on the LaunchPad
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tm4c123gh6pm.h"
+#include "gpio.h"
+#include "measure.h"
+#include "sort.h"
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+MEASUREMENT_TYPE sortType = MEASURE_NONE;
+float sortNominal = 0;
+uint8_t sortTolerances[SORT_MAX_BANDS];
+uint8_t sortBandCount = 0;
+
+// Band limits in the units of the measurement, worked out once so sorting a part needs no division
+float sortLow[SORT_MAX_BANDS];
+float sortHigh[SORT_MAX_BANDS];
+
+SORT_COUNTS sortCounts;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initSorter()
+{
+    enablePort(PORTF);
+
+    // The strobe latches on the falling edge, it is polled so the interrupt stays masked
+    selectPinDigitalInput(PART_PRESENT);
+    enablePinPullup(PART_PRESENT);
+    selectPinInterruptFallingEdge(PART_PRESENT);
+
+    selectPinPushPullOutput(SORT_FAIL);
+    selectPinPushPullOutput(SORT_BIN);
+    selectPinPushPullOutput(SORT_PASS);
+
+    clearSortOutputs();
+    clearPartPresent();
+    resetSortCounts();
+}
+
+// Nominal is in the units of the measurement result (Ohm or uF)
+// Tolerances are in percent, up to SORT_MAX_TOLERANCE, and have to get wider from one band to the next
+bool setSortLimits(MEASUREMENT_TYPE type, float nominal, const uint8_t tolerances[], uint8_t count)
+{
+    uint8_t i;
+
+    if(type != MEASURE_RESISTANCE && type != MEASURE_CAPACITANCE)
+        return false;
+    if(nominal <= 0 || count == 0 || count > SORT_MAX_BANDS)
+        return false;
+    for(i = 0; i < count; i++)
+        if(tolerances[i] > SORT_MAX_TOLERANCE || (i > 0 && tolerances[i] <= tolerances[i - 1]))
+            return false;
+
+    sortType = type;
+    sortNominal = nominal;
+    sortBandCount = count;
+    for(i = 0; i < count; i++)
+    {
+        sortTolerances[i] = tolerances[i];
+        sortLow[i] = nominal * (100 - tolerances[i]) / 100;
+        sortHigh[i] = nominal * (100 + tolerances[i]) / 100;
+    }
+    return true;
+}
+
+MEASUREMENT_TYPE getSortType()
+{
+    return sortType;
+}
+
+float getSortNominal()
+{
+    return sortNominal;
+}
+
+// Copies the tolerances of the bands, returns how many there are
+uint8_t getSortBands(uint8_t tolerances[])
+{
+    uint8_t i;
+    for(i = 0; i < sortBandCount; i++)
+        tolerances[i] = sortTolerances[i];
+    return sortBandCount;
+}
+
+// True once a part has been strobed in, stays set until clearPartPresent()
+bool isPartPresent()
+{
+    return getPinInterruptStatus(PART_PRESENT);
+}
+
+void clearPartPresent()
+{
+    clearPinInterrupt(PART_PRESENT);
+}
+
+void clearSortOutputs()
+{
+    setPinValue(SORT_FAIL, 0);
+    setPinValue(SORT_BIN, 0);
+    setPinValue(SORT_PASS, 0);
+}
+
+// Puts the result in the narrowest band it fits in and drives the outputs
+// Returns the bin (1 to the number of bands), or 0 if the part failed
+uint8_t sortResult(MEASUREMENT_RESULT* result)
+{
+    uint8_t bin = 0;
+    uint8_t i;
+
+    if(result->type == sortType && result->status == RESULT_OK)
+    {
+        for(i = 0; i < sortBandCount && bin == 0; i++)
+            if(result->value >= sortLow[i] && result->value <= sortHigh[i])
+                bin = i + 1;
+    }
+
+    setPinValue(SORT_FAIL, bin == 0);
+    setPinValue(SORT_BIN, bin == 2 || bin == 3);
+    setPinValue(SORT_PASS, bin == 1 || bin == 3);
+
+    sortCounts.total++;
+    if(bin == 0)
+        sortCounts.fail++;
+    else
+        sortCounts.bins[bin - 1]++;
+    return bin;
+}
+
+void resetSortCounts()
+{
+    uint8_t i;
+    sortCounts.total = 0;
+    sortCounts.fail = 0;
+    for(i = 0; i < SORT_MAX_BANDS; i++)
+        sortCounts.bins[i] = 0;
+}
+
+void getSortCounts(SORT_COUNTS* counts)
+{
+    *counts = sortCounts;
+}
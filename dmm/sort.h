@@ -0,0 +1,67 @@
+// Sorting Library
+// Sarker Nadir Afridi Azmi
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Hardware configuration:
+// Part present strobe on PF4, active low (SW1 on the LaunchPad)
+// Results on PF1 (FAIL), PF2 (BIN) and PF3 (PASS), the RGB LED on the LaunchPad
+//   bin 1 = PASS, bin 2 = BIN, bin 3 = PASS + BIN, out of tolerance = FAIL
+//   The outputs are cleared when the next part is strobed
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef SORT_H_
+#define SORT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "measure.h"
+
+#define PART_PRESENT            PORTF,4
+#define SORT_FAIL               PORTF,1
+#define SORT_BIN                PORTF,2
+#define SORT_PASS               PORTF,3
+
+#define SORT_MAX_BANDS          3
+// A wider band would take in everything down to 0
+#define SORT_MAX_TOLERANCE      100
+
+//-----------------------------------------------------------------------------
+// Structs
+//-----------------------------------------------------------------------------
+
+typedef struct _SORT_COUNTS
+{
+    uint32_t total;
+    uint32_t fail;
+    uint32_t bins[SORT_MAX_BANDS];
+} SORT_COUNTS;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initSorter();
+bool setSortLimits(MEASUREMENT_TYPE type, float nominal, const uint8_t tolerances[], uint8_t count);
+MEASUREMENT_TYPE getSortType();
+float getSortNominal();
+uint8_t getSortBands(uint8_t tolerances[]);
+
+bool isPartPresent();
+void clearPartPresent();
+void clearSortOutputs();
+uint8_t sortResult(MEASUREMENT_RESULT* result);
+
+void resetSortCounts();
+void getSortCounts(SORT_COUNTS* counts);
+
+#endif
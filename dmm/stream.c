@@ -0,0 +1,203 @@
+// Streaming Library
+// Sarker Nadir Afridi Azmi
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Hardware configuration:
+// UART0, results are queued with queueUart0() so the measurement keeps running while they go out
+// A line that doesn't fit in the transmit queue waits in resultLine until sendResultLine() gets it in
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tm4c123gh6pm.h"
+#include "uart0.h"
+#include "wait.h"
+#include "measure.h"
+#include "format.h"
+#include "profile.h"
+#include "scheduler.h"
+#include "stream.h"
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+char resultLine[100];
+// Set while resultLine is waiting for room in the transmit queue
+bool isResultPending = false;
+
+STREAM_STATE streamState = STREAM_OFF;
+MEASUREMENT_TYPE streamType = MEASURE_NONE;
+// The period and the time of the next request are in us, so a rate that doesn't divide 1000 still comes out right
+uint32_t streamPeriod = 0;
+uint32_t streamStart = 0;
+uint32_t streamNext = 0;
+uint32_t streamReadings = 0;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Queues the pending line if there is room for it now, returns true once nothing is waiting
+// A caller that gets false tries again on its next pass instead of waiting here
+bool sendResultLine()
+{
+    if(isResultPending)
+    {
+        PROFILE_START(PROBE_UART_TX);
+        isResultPending = !queueUart0(resultLine);
+        PROFILE_STOP(PROBE_UART_TX);
+    }
+    return !isResultPending;
+}
+
+// Only call once sendResultLine() is true, the line is formatted into resultLine
+void printMeasurementResult(MEASUREMENT_RESULT* result)
+{
+    const char* statusNames[] = {"", "open", "short", "over-range"};
+    const char* unit;
+    float value;
+    char* end;
+
+    PROFILE_START(PROBE_FORMAT);
+    // Capacitance and inductance come out of the engine in uF and uH
+    switch(result->type)
+    {
+        case MEASURE_RESISTANCE:
+            end = formatString(resultLine, "Resistance = ");
+            value = result->value;
+            unit = "Ohm";
+            break;
+        case MEASURE_CAPACITANCE:
+            end = formatString(resultLine, "Capacitance = ");
+            value = result->value * 1e-6f;
+            unit = "F";
+            break;
+        case MEASURE_INDUCTANCE:
+            end = formatString(resultLine, "Inductance = ");
+            value = result->value * 1e-6f;
+            unit = "H";
+            break;
+        default:
+            return;
+    }
+
+    if(result->status == RESULT_OK)
+        end = formatEngineering(end, value, unit);
+    else
+        end = formatString(end, statusNames[result->status]);
+
+    if(result->isAuto)
+    {
+        end = formatString(end, " (auto, ");
+        end = formatUnsigned(end, result->confidence * 100 + 0.5f);
+        end = formatString(end, "% confidence)");
+    }
+    formatString(end, "\n");
+    PROFILE_STOP(PROBE_FORMAT);
+
+    // Everything reported from the start of a stream until it has stopped is one of its readings
+    if(streamState == STREAM_RUNNING || streamState == STREAM_STOPPING)
+        streamReadings++;
+    isResultPending = true;
+    sendResultLine();
+}
+
+// Measures the same component over and over from streamTask() until stopStream()
+// A rate of 0 starts the next measurement as soon as the previous one is done
+void startStream(MEASUREMENT_TYPE type, uint32_t rate)
+{
+    streamType = type;
+    streamPeriod = (rate > 0) ? (1000000 + rate / 2) / rate : 0;
+    streamStart = getMilliseconds();
+    streamReadings = 0;
+    streamState = STREAM_STARTING;
+    postEvent(EVENT_STREAM);
+}
+
+// No new measurement starts after this, the ones already in the engine are still reported
+void stopStream()
+{
+    if(streamState == STREAM_STARTING || streamState == STREAM_RUNNING)
+    {
+        streamState = STREAM_STOPPING;
+        postEvent(EVENT_STREAM);
+    }
+}
+
+// True from startStream() until the summary is queued
+bool isStreaming()
+{
+    return streamState != STREAM_OFF;
+}
+
+// Runs every ms and on EVENT_STREAM, posts EVENT_COMMAND_DONE once the summary is queued
+// The next request is queued while the current one runs, so the engine goes straight on to
+// its discharge while the result before it is still being formatted and sent
+void streamTask()
+{
+    char* end;
+    uint32_t elapsed;
+
+    switch(streamState)
+    {
+        case STREAM_OFF:
+            break;
+        case STREAM_STARTING:
+            // Whatever was asked for before the stream is reported ahead of it
+            if(!isMeasurementIdle() || !sendResultLine())
+                break;
+            formatString(resultLine, "Streaming, press any key to stop\n");
+            isResultPending = true;
+            sendResultLine();
+            streamStart = getMilliseconds();
+            streamNext = getMicroseconds();
+            streamState = STREAM_RUNNING;
+            // fall through
+        case STREAM_RUNNING:
+            // measurementTask() posts EVENT_STREAM when the engine takes the request, otherwise the SysTick
+            // brings the next period around
+            // A request can go out up to a ms late, the next one is still due a period after the last was
+            // Nothing new starts while a line waits for the transmit queue, the captures would only pile up
+            if(!isMeasurementRequestPending() && !isResultPending && (int32_t)(getMicroseconds() - streamNext) >= 0)
+            {
+                requestMeasurement(streamType);
+                streamNext += streamPeriod;
+                // A request that went out late is made up for, but nothing more than one period behind
+                if((int32_t)(getMicroseconds() - streamNext) > (int32_t)streamPeriod)
+                    streamNext = getMicroseconds();
+            }
+            break;
+        case STREAM_STOPPING:
+            // The stop key only stops new readings from starting, reportTask() still sends the rest
+            if(!isMeasurementIdle() || !sendResultLine())
+                break;
+            elapsed = getMilliseconds() - streamStart;
+            end = formatUnsigned(resultLine, streamReadings);
+            end = formatString(end, " readings in ");
+            end = formatUnsigned(end, elapsed);
+            end = formatString(end, " ms, ");
+            // Readings per second with two decimals, as a scaled integer
+            end = formatFixed(end, elapsed ? ((uint64_t)streamReadings * 100000) / elapsed : 0, 2);
+            formatString(end, " readings/sec\n");
+            isResultPending = true;
+            streamState = STREAM_SUMMARY;
+            // fall through
+        case STREAM_SUMMARY:
+            if(!sendResultLine())
+                break;
+            streamState = STREAM_OFF;
+            postEvent(EVENT_COMMAND_DONE);
+            break;
+    }
+}
@@ -0,0 +1,57 @@
+// Streaming Library
+// Sarker Nadir Afridi Azmi
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Hardware configuration:
+// UART0, results are queued with queueUart0() so the measurement keeps running while they go out
+// A line that doesn't fit in the transmit queue waits in resultLine until sendResultLine() gets it in
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef STREAM_H_
+#define STREAM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "measure.h"
+
+//-----------------------------------------------------------------------------
+// Structs
+//-----------------------------------------------------------------------------
+
+/*
+ * Phases of a stream, stepped by streamTask()
+ * OFF -> STARTING -> RUNNING -> STOPPING -> SUMMARY -> OFF
+ * STARTING waits for the engine to be idle, STOPPING for the readings still in it to be reported
+ */
+typedef enum _STREAM_STATE
+{
+    STREAM_OFF,
+    STREAM_STARTING,
+    STREAM_RUNNING,
+    STREAM_STOPPING,
+    STREAM_SUMMARY
+} STREAM_STATE;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+bool sendResultLine();
+void printMeasurementResult(MEASUREMENT_RESULT* result);
+
+void startStream(MEASUREMENT_TYPE type, uint32_t rate);
+void stopStream();
+bool isStreaming();
+void streamTask();
+
+#endif
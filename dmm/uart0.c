@@ -13,6 +13,8 @@
 // UART Interface:
 //   U0TX (PA1) and U0RX (PA0) are connected to the 2nd controller
 //   The USB on the 2nd controller enumerates to an ICDI interface and a virtual COM port
+//   After enableUart0Interrupts() both directions go through the queues and uart0Isr()
+//   After enableUart0Dma() whole buffers can go out on uDMA channel 9
 
 //-----------------------------------------------------------------------------
 // Device includes, defines, and assembler directives
@@ -21,6 +23,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "tm4c123gh6pm.h"
+#include "dma.h"
 #include "uart0.h"
 
 // PortA masks
@@ -31,6 +34,29 @@
 // Global variables
 //-----------------------------------------------------------------------------
 
+// Software transmit queue in front of the 16-level FIFO, emptied by serviceUart0() or uart0Isr()
+// With the interrupts on, only the ISR moves the tail and only the main code moves the head, so there is no lock
+volatile char txQueue[UART0_TX_QUEUE_SIZE];
+volatile uint16_t txQueueHead = 0;
+volatile uint16_t txQueueTail = 0;
+
+// Receive queue, filled by uart0Isr(), characters that don't fit are dropped
+volatile char rxQueue[UART0_RX_QUEUE_SIZE];
+volatile uint8_t rxQueueHead = 0;
+volatile uint8_t rxQueueTail = 0;
+
+bool isUart0InterruptDriven = false;
+
+uint32_t uart0BaudRate = 0;
+int32_t uart0BaudError = 0;
+
+// The buffer going out on DMA, more than DMA_MAX_TRANSFER bytes go in pieces
+bool isUart0DmaAvailable = false;
+volatile bool isDmaBusy = false;
+const uint8_t* dmaData;
+uint16_t dmaRemaining;
+UART0_DMA_CALLBACK dmaCallback;
+
 //-----------------------------------------------------------------------------
 // Subroutines
 //-----------------------------------------------------------------------------
@@ -53,43 +79,278 @@ void initUart0()
     GPIO_PORTA_PCTL_R |= GPIO_PCTL_PA1_U0TX | GPIO_PCTL_PA0_U0RX;
                                                         // select UART0 to drive pins PA0 and PA1: default, added for clarity
 
-    // Configure UART0 to 115200 baud, 8N1 format
+    // Configure UART0 to use the system clock, the rate, the 8N1 format and the enable come from setUart0BaudRate()
     UART0_CTL_R = 0;                                    // turn-off UART0 to allow safe programming
-    UART0_CC_R = UART_CC_CS_SYSCLK;                     // use system clock (40 MHz)
-    UART0_IBRD_R = 21;                                  // r = 40 MHz / (Nx115.2kHz), set floor(r)=21, where N=16
-    UART0_FBRD_R = 45;                                  // round(fract(r)*64)=45
-    UART0_LCRH_R = UART_LCRH_WLEN_8 | 111000;           // configure for 8N1 w/ 16-level FIFO
-    UART0_CTL_R = UART_CTL_TXE | UART_CTL_RXE | UART_CTL_UARTEN;
+    UART0_CC_R = UART_CC_CS_SYSCLK;                     // use system clock
+}
+
+// Works out the divisor r = fcyc / (N x baudRate) in units of 1/64 (IBRD:FBRD), where N = 16,
+// or N = 8 (high speed mode) if the rate is above fcyc / 16
+// Returns false if r is out of range or the rate it makes is off by more than UART0_MAX_BAUD_ERROR
+bool getUart0Divisor(uint32_t baudRate, uint32_t fcyc, uint32_t* divisor, bool* isHighSpeed, int32_t* error)
+{
+    uint64_t n;
+    if (baudRate == 0)
+        return false;
+    *isHighSpeed = (uint64_t)baudRate * 16 > fcyc;
+    n = *isHighSpeed ? 8 : 16;
+    *divisor = (((uint64_t)fcyc * 128) / (n * baudRate) + 1) >> 1;
+    if (*divisor < 64 || *divisor > 65535 * 64)         // IBRD is 1 to 65535, FBRD has to be 0 at 65535
+        return false;
+    // The rate made is fcyc x 64 / (N x divisor), the error is in ppm of the rate asked for
+    *error = (int32_t)((int64_t)(((uint64_t)fcyc * 64000000) / (n * *divisor * baudRate)) - 1000000);
+    return *error <= UART0_MAX_BAUD_ERROR && *error >= -UART0_MAX_BAUD_ERROR;
+}
+
+// Set baud rate as function of instruction cycle frequency, with 8N1 format
+// Anything still queued or going out on DMA is sent at the old rate first
+// Returns false and leaves the rate as it was if the rate can't be made closely enough
+bool setUart0BaudRate(uint32_t baudRate, uint32_t fcyc)
+{
+    uint32_t divisor;
+    bool isHighSpeed;
+    int32_t error;
+
+    if (!getUart0Divisor(baudRate, fcyc, &divisor, &isHighSpeed, &error))
+        return false;
+    while (isDmaBusy || txQueueHead != txQueueTail || (UART0_FR_R & UART_FR_BUSY))
+        serviceUart0();
+
+    UART0_CTL_R = 0;                                    // turn-off UART0 to allow safe programming
+    UART0_IBRD_R = divisor >> 6;                        // set integer value to floor(r)
+    UART0_FBRD_R = divisor & 63;                        // set fractional value to round(fract(r)*64)
+    UART0_LCRH_R = UART_LCRH_WLEN_8 | UART_LCRH_FEN;    // configure for 8N1 w/ 16-level FIFO, the divisor is only
+                                                        // loaded on this write
+    UART0_CTL_R = UART_CTL_TXE | UART_CTL_RXE | UART_CTL_UARTEN | (isHighSpeed ? UART_CTL_HSE : 0);
                                                         // enable TX, RX, and module
+    uart0BaudRate = baudRate;
+    uart0BaudError = error;
+    return true;
+}
+
+// The rate last set and its error in ppm (the rate made is above the one asked for if positive)
+uint32_t getUart0BaudRate()
+{
+    return uart0BaudRate;
+}
+
+int32_t getUart0BaudError()
+{
+    return uart0BaudError;
+}
+
+bool isUart0HighSpeed()
+{
+    return (UART0_CTL_R & UART_CTL_HSE) != 0;
+}
+
+// Interrupt when the tx fifo is down to 2 characters or anything comes in
+void enableUart0Interrupts()
+{
+    UART0_IFLS_R = UART_IFLS_TX1_8 | UART_IFLS_RX1_8;
+    UART0_ICR_R = UART_ICR_TXIC | UART_ICR_RXIC | UART_ICR_RTIC;
+    UART0_IM_R = UART_IM_TXIM | UART_IM_RXIM | UART_IM_RTIM;
+    isUart0InterruptDriven = true;
+    NVIC_EN0_R |= 1 << (INT_UART0-16);
+}
+
+void fillTxFifo()
+{
+    while (txQueueHead != txQueueTail && !(UART0_FR_R & UART_FR_TXFF))
+    {
+        UART0_DR_R = txQueue[txQueueTail];
+        txQueueTail = (txQueueTail + 1) & (UART0_TX_QUEUE_SIZE - 1);
+    }
+}
+
+// Needs enableUart0Interrupts() too, the end of a transfer comes in on the UART0 interrupt
+void enableUart0Dma()
+{
+    initDma();
+    isUart0DmaAvailable = true;
+}
+
+bool isUart0DmaEnabled()
+{
+    return isUart0DmaAvailable && isUart0InterruptDriven;
+}
+
+void startDmaPiece()
+{
+    uint16_t size = (dmaRemaining > DMA_MAX_TRANSFER) ? DMA_MAX_TRANSFER : dmaRemaining;
+    startDmaToPeripheral(DMA_CHANNEL_UART0_TX, dmaData, &UART0_DR_R, size, UDMA_CHCTL_ARBSIZE_2);
+    dmaData += size;
+    dmaRemaining -= size;
+}
+
+// Sends a buffer with no CPU time, the buffer has to stay as it is until the callback
+// Returns false if a transfer is still going or characters are still queued (they have to go first)
+// The callback may be 0, otherwise it is called once each buffer is done and can hand over the next one
+// Characters queued while the transfer runs go out after it
+bool sendUart0Dma(const void* data, uint16_t size, UART0_DMA_CALLBACK callback)
+{
+    if (!isUart0DmaEnabled() || isDmaBusy || txQueueHead != txQueueTail || size == 0)
+        return false;
+    dmaData = data;
+    dmaRemaining = size;
+    dmaCallback = callback;
+    UART0_DMACTL_R |= UART_DMACTL_TXDMAE;
+    startDmaPiece();
+    // Busy only once the channel is on, so the ISR can't take it as done first
+    // A short buffer may already be done, so the ISR is run to check
+    isDmaBusy = true;
+    NVIC_SW_TRIG_R = INT_UART0-16;
+    return true;
+}
+
+bool isUart0DmaBusy()
+{
+    return isDmaBusy;
+}
+
+// The end of a DMA transfer starts the next piece or buffer
+void finishDmaPiece()
+{
+    const void* data;
+    uint16_t size;
+
+    clearDmaInterrupt(DMA_CHANNEL_UART0_TX);
+    if (dmaRemaining == 0 && dmaCallback != 0 && dmaCallback(&data, &size) && size > 0)
+    {
+        dmaData = data;
+        dmaRemaining = size;
+    }
+    if (dmaRemaining > 0)
+        startDmaPiece();
+    else
+    {
+        UART0_DMACTL_R &= ~UART_DMACTL_TXDMAE;
+        isDmaBusy = false;
+    }
+}
+
+// The fifo interrupt only comes on the way down past the level, so an idle transmitter is started from here
+// The queue waits while a DMA transfer has the fifo
+void uart0Isr()
+{
+    UART0_ICR_R = UART_ICR_TXIC | UART_ICR_RXIC | UART_ICR_RTIC;
+    if (isDmaBusy && isDmaDone(DMA_CHANNEL_UART0_TX))
+        finishDmaPiece();
+    while (!(UART0_FR_R & UART_FR_RXFE))
+    {
+        char c = UART0_DR_R & 0xFF;
+        uint8_t next = (rxQueueHead + 1) & (UART0_RX_QUEUE_SIZE - 1);
+        if (next != rxQueueTail)
+        {
+            rxQueue[rxQueueHead] = c;
+            rxQueueHead = next;
+        }
+    }
+    if (!isDmaBusy)
+        fillTxFifo();
+}
+
+// Moves queued characters into the tx fifo until either one runs out, never waits
+// With the interrupts on, this pends uart0Isr() to do it instead
+void serviceUart0()
+{
+    if (!isUart0InterruptDriven)
+        fillTxFifo();
+    else if (txQueueHead != txQueueTail)
+        NVIC_SW_TRIG_R = INT_UART0-16;
+}
+
+// Non-blocking function that queues a whole string, or nothing if there is no room for all of it
+bool queueUart0(char* str)
+{
+    uint16_t length = 0;
+    uint16_t free = (txQueueTail - txQueueHead - 1) & (UART0_TX_QUEUE_SIZE - 1);
+    while (str[length] != '\0')
+        length++;
+    if (length > free)
+        return false;
+    while (*str != '\0')
+    {
+        txQueue[txQueueHead] = *str++;
+        txQueueHead = (txQueueHead + 1) & (UART0_TX_QUEUE_SIZE - 1);
+    }
+    serviceUart0();
+    return true;
+}
+
+// Returns true once everything queued has gone into the tx fifo
+bool isUart0QueueEmpty()
+{
+    return txQueueHead == txQueueTail;
 }
 
-// Set baud rate as function of instruction cycle frequency
-void setUart0BaudRate(uint32_t baudRate, uint32_t fcyc)
+// Adds a character to the transmit queue, waits for the ISR to make room if it is full
+// Returns false if it had to wait
+bool pushTxQueue(char c)
 {
-    uint32_t divisorTimes128 = (fcyc * 8) / baudRate;   // calculate divisor (r) in units of 1/128,
-                                                        // where r = fcyc / 16 * baudRate
-    UART0_IBRD_R = divisorTimes128 >> 7;                // set integer value to floor(r)
-    UART0_FBRD_R = (((divisorTimes128 + 1)) >> 1) & 63; // set fractional value to round(fract(r)*64)
+    bool isRoom = true;
+    uint16_t next = (txQueueHead + 1) & (UART0_TX_QUEUE_SIZE - 1);
+    if (next == txQueueTail)
+    {
+        isRoom = false;
+        while (next == txQueueTail)
+            serviceUart0();
+    }
+    txQueue[txQueueHead] = c;
+    txQueueHead = next;
+    return isRoom;
 }
 
 // Blocking function that writes a serial character when the UART buffer is not full
+// Anything still queued goes out first so the output stays in order
+// With the interrupts on, this only waits if the transmit queue is full
 void putcUart0(char c)
 {
+    if (isUart0InterruptDriven)
+    {
+        pushTxQueue(c);
+        serviceUart0();
+        return;
+    }
+    while (txQueueHead != txQueueTail)
+        serviceUart0();
     while (UART0_FR_R & UART_FR_TXFF);               // wait if uart0 tx fifo full
     UART0_DR_R = c;                                  // write character to fifo
 }
 
-// Blocking function that writes a string when the UART buffer is not full
-void putsUart0(char* str)
+// Writes a string, blocking until it is all in the fifo
+// With the interrupts on, it is queued like queueUart0(), and only waits for the ISR to make room if the queue is full
+// From an ISR it cannot wait, it returns false if there was no room and nothing is queued
+bool putsUart0(char* str)
 {
-    uint8_t i = 0;
+    uint16_t i = 0;
+    if (!isUart0InterruptDriven)
+    {
+        while (str[i] != '\0')
+            putcUart0(str[i++]);
+        return true;
+    }
+    if (queueUart0(str))
+        return true;
+    if (NVIC_INT_CTRL_R & NVIC_INT_CTRL_VEC_ACT_M)
+        return false;
     while (str[i] != '\0')
-        putcUart0(str[i++]);
+        pushTxQueue(str[i++]);
+    serviceUart0();
+    return true;
 }
 
 // Blocking function that returns with serial data once the buffer is not empty
 char getcUart0()
 {
+    char c;
+    if (isUart0InterruptDriven)
+    {
+        while (rxQueueHead == rxQueueTail);
+        c = rxQueue[rxQueueTail];
+        rxQueueTail = (rxQueueTail + 1) & (UART0_RX_QUEUE_SIZE - 1);
+        return c;
+    }
     while (UART0_FR_R & UART_FR_RXFE);               // wait if uart0 rx fifo empty
     return UART0_DR_R & 0xFF;                        // get character from fifo
 }
@@ -97,5 +358,7 @@ char getcUart0()
 // Returns the status of the receive buffer
 bool kbhitUart0()
 {
+    if (isUart0InterruptDriven)
+        return rxQueueHead != rxQueueTail;
     return !(UART0_FR_R & UART_FR_RXFE);
 }
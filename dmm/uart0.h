@@ -13,6 +13,7 @@
 // UART Interface:
 //   U0TX (PA1) and U0RX (PA0) are connected to the 2nd controller
 //   The USB on the 2nd controller enumerates to an ICDI interface and a virtual COM port
+//   Above fcyc / 16 baud the UART runs in high speed mode (8x oversampling), up to fcyc / 8
 
 //-----------------------------------------------------------------------------
 // Device includes, defines, and assembler directives
@@ -21,14 +22,37 @@
 #ifndef UART0_H_
 #define UART0_H_
 
+// Size of the software transmit and receive queues, must be powers of 2
+// The terminal only takes a line once the transmit queue is empty, the longest reply (prof) has to fit in it
+#define UART0_TX_QUEUE_SIZE 1024
+#define UART0_RX_QUEUE_SIZE 64
+
+// Largest error of the baud rate divisor allowed, in ppm (2%)
+#define UART0_MAX_BAUD_ERROR 20000
+
+// Called from uart0Isr() when a DMA buffer is done, gives the next buffer and returns true to carry on
+typedef bool (*UART0_DMA_CALLBACK)(const void** data, uint16_t* size);
+
 //-----------------------------------------------------------------------------
 // Subroutines
 //-----------------------------------------------------------------------------
 
 void initUart0();
-void setUart0BaudRate(uint32_t baudRate, uint32_t fcyc);
+bool setUart0BaudRate(uint32_t baudRate, uint32_t fcyc);
+uint32_t getUart0BaudRate();
+int32_t getUart0BaudError();
+bool isUart0HighSpeed();
+void enableUart0Interrupts();
+void uart0Isr();
+void enableUart0Dma();
+bool isUart0DmaEnabled();
+bool sendUart0Dma(const void* data, uint16_t size, UART0_DMA_CALLBACK callback);
+bool isUart0DmaBusy();
+void serviceUart0();
+bool queueUart0(char* str);
+bool isUart0QueueEmpty();
 void putcUart0(char c);
-void putsUart0(char* str);
+bool putsUart0(char* str);
 char getcUart0();
 bool kbhitUart0();
 
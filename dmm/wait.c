@@ -8,30 +8,124 @@
 // Target uC:       TM4C123GH6PM
 // System Clock:    40 MHz
 
+// Hardware configuration:
+// SysTick, 1 ms interrupt, the time base of every delay
+
 //-----------------------------------------------------------------------------
 // Device includes, defines, and assembler directives
 //-----------------------------------------------------------------------------
 #include <stdint.h>
+#include <stdbool.h>
 #include "tm4c123gh6pm.h"
 #include "wait.h"
 
+#define SYSTICK_RELOAD          (SYSTEM_CLOCK_HZ / SYSTICK_RATE_HZ)
+#define CLOCKS_PER_MICROSECOND  (SYSTEM_CLOCK_HZ / 1000000)
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+volatile uint32_t milliseconds = 0;
+bool isSystickStarted = false;
+
 //-----------------------------------------------------------------------------
 // Subroutines
 //-----------------------------------------------------------------------------
 
-// Approximate busy waiting (in units of microseconds), given a 40 MHz system clock
+// Sleeps through the whole milliseconds of the wait, the SysTick wakes the core for each one,
+// then polls the SysTick count for the rest
+// Not for ISRs, the SysTick can't wake an ISR of the same or higher priority
 void waitMicrosecond(uint32_t us)
 {
-	__asm("WMS_LOOP0:   MOV  R1, #6");          // 1
-    __asm("WMS_LOOP1:   SUB  R1, #1");          // 6
-    __asm("             CBZ  R1, WMS_DONE1");   // 5+1*3
-    __asm("             NOP");                  // 5
-    __asm("             NOP");                  // 5
-    __asm("             B    WMS_LOOP1");       // 5*2 (speculative, so P=1)
-    __asm("WMS_DONE1:   SUB  R0, #1");          // 1
-    __asm("             CBZ  R0, WMS_DONE0");   // 1
-	__asm("             NOP");                  // 1
-    __asm("             B    WMS_LOOP0");       // 1*2 (speculative, so P=1)
-    __asm("WMS_DONE0:");                        // ---
-                                                // 40 clocks/us + error
+    DELAY delay;
+    startDelay(&delay, us);
+    while(getDelayRemaining(&delay) > 1000000 / SYSTICK_RATE_HZ)
+        waitForInterrupt();
+    while(!isDelayExpired(&delay));
+}
+
+// Start a 1 ms SysTick
+void initSystickTimer()
+{
+    NVIC_ST_CTRL_R = 0;                              // turn-off SysTick before reconfiguring
+    NVIC_ST_RELOAD_R = SYSTICK_RELOAD - 1;
+    NVIC_ST_CURRENT_R = 0;
+    NVIC_ST_CTRL_R = NVIC_ST_CTRL_CLK_SRC | NVIC_ST_CTRL_INTEN | NVIC_ST_CTRL_ENABLE;
+    isSystickStarted = true;
+}
+
+void systickIsr()
+{
+    milliseconds++;
+}
+
+// Milliseconds since initSystickTimer(), wraps after about 49 days
+uint32_t getMilliseconds()
+{
+    return milliseconds;
+}
+
+// Microseconds since initSystickTimer(), wraps after about 71 minutes
+// The count is read again if the SysTick interrupt came in between
+uint32_t getMicroseconds()
+{
+    uint32_t ms;
+    uint32_t current;
+    do
+    {
+        ms = milliseconds;
+        current = NVIC_ST_CURRENT_R;
+    } while(ms != milliseconds);
+    return ms * (1000000 / SYSTICK_RATE_HZ) + (SYSTICK_RELOAD - 1 - current) / CLOCKS_PER_MICROSECOND;
+}
+
+// Starts the SysTick if nothing has yet, the init code waits before main() gets to it
+void startDelay(DELAY* delay, uint32_t us)
+{
+    if(!isSystickStarted)
+        initSystickTimer();
+    delay->start = getMicroseconds();
+    delay->length = us;
+}
+
+bool isDelayExpired(DELAY* delay)
+{
+    return getMicroseconds() - delay->start >= delay->length;
+}
+
+uint32_t getDelayRemaining(DELAY* delay)
+{
+    uint32_t elapsed = getMicroseconds() - delay->start;
+    return elapsed >= delay->length ? 0 : delay->length - elapsed;
+}
+
+// Sleeps until the next interrupt
+void waitForInterrupt()
+{
+#ifdef SIMULATOR
+    simWaitForInterrupt();
+#else
+    __asm("             WFI");
+#endif
+}
+
+// Masks every interrupt (PRIMASK), one that comes in meanwhile is taken by enableInterrupts()
+// A pending interrupt still wakes waitForInterrupt() while masked
+void disableInterrupts()
+{
+#ifdef SIMULATOR
+    simDisableInterrupts();
+#else
+    __asm("             CPSID  I");
+#endif
+}
+
+void enableInterrupts()
+{
+#ifdef SIMULATOR
+    simEnableInterrupts();
+#else
+    __asm("             CPSIE  I");
+#endif
 }
@@ -8,13 +8,43 @@
 // Target uC:       TM4C123GH6PM
 // System Clock:    40 MHz
 
+// Hardware configuration:
+// SysTick, 1 ms interrupt, the time base of every delay
+
 #ifndef WAIT_H_
 #define WAIT_H_
 
+#include <stdint.h>
+#include <stdbool.h>
+
+// Every wait is worked out from this, change it with the clock
+#define SYSTEM_CLOCK_HZ         40000000
+#define SYSTICK_RATE_HZ         1000
+
+//-----------------------------------------------------------------------------
+// Structs
+//-----------------------------------------------------------------------------
+
+// A delay belongs to whoever started it, so any number of them can be pending at once
+typedef struct _DELAY
+{
+    uint32_t start;                 // us
+    uint32_t length;                // us
+} DELAY;
+
 //-----------------------------------------------------------------------------
 // Subroutines
 //-----------------------------------------------------------------------------
 
 void waitMicrosecond(uint32_t us);
+void initSystickTimer();
+uint32_t getMilliseconds();
+uint32_t getMicroseconds();
+void startDelay(DELAY* delay, uint32_t us);
+bool isDelayExpired(DELAY* delay);
+uint32_t getDelayRemaining(DELAY* delay);
+void waitForInterrupt();
+void disableInterrupts();
+void enableInterrupts();
 
 #endif